@@ -0,0 +1,114 @@
+// The performance-relevant patterns of examples.cpp as benchmark kernels.
+//
+// Each kernel builds the example's result from prebuilt operands and reads
+// `reads` coefficients of it, as the examples do when printing. With auto the
+// result is an expression: every coefficient read constructs a fresh product
+// evaluator, so the whole matrix product is recomputed per read. The eval()
+// variants compute it once, and eigen_auto::lazy_eval computes it once on the
+// first read (not at all with --reads 0).
+//
+// Every kernel also states its FLOP count and its compulsory memory traffic
+// (operands read once, results written once, 8 bytes per double) for the
+// roofline report; cache-blocking overheads of the product are not counted.
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <eigen_auto/lazy_eval.h>
+
+namespace examples_benchmark {
+
+using Eigen::Index;
+using Eigen::MatrixXd;
+
+// Operands shared by all kernels of one matrix size. Matrix is MatrixXd for
+// the throughput kernels; --latency also uses fixed-size matrices.
+template <typename Matrix>
+struct BasicOperands {
+    explicit BasicOperands(Index n)
+        : n(n), A(Matrix::Random(n, n)), B(Matrix::Random(n, n)),
+          D(Matrix::Random(n, n)) {}
+
+    Index n;
+    Matrix A;
+    Matrix B;
+    Matrix D;
+};
+
+using Operands = BasicOperands<MatrixXd>;
+
+// Reads coefficients along the diagonal so that no read is trivially reused.
+template <typename Result>
+double read_coefficients(const Result& C, Index n, int reads) {
+    double sum = 0.0;
+    for (int i = 0; i < reads; ++i) {
+        sum += C(i % n, i % n);
+    }
+    return sum;
+}
+
+// example1: auto C = A * B;  each read recomputes A * B
+template <typename Matrix>
+double example1_auto_product(const BasicOperands<Matrix>& x, int reads) {
+    auto C = x.A * x.B;
+    return read_coefficients(C, x.n, reads);
+}
+
+// example4: auto C = (A * B).eval();
+template <typename Matrix>
+double example4_eval_product(const BasicOperands<Matrix>& x, int reads) {
+    auto C = (x.A * x.B).eval();
+    return read_coefficients(C, x.n, reads);
+}
+
+// example1 memoized: eigen_auto::lazy_eval C(A * B);  the first read computes A * B
+template <typename Matrix>
+double example1_lazy_product(const BasicOperands<Matrix>& x, int reads) {
+    const eigen_auto::lazy_eval C(x.A * x.B);
+    return read_coefficients(C, x.n, reads);
+}
+
+// example7: auto C = A * B + D.transpose();  each read recomputes A * B
+template <typename Matrix>
+double example7_auto_complex(const BasicOperands<Matrix>& x, int reads) {
+    auto C = x.A * x.B + x.D.transpose();
+    return read_coefficients(C, x.n, reads);
+}
+
+// example7 fixed: the sum evaluated once into a plain matrix
+template <typename Matrix>
+double example7_eval_complex(const BasicOperands<Matrix>& x, int reads) {
+    Matrix C = x.A * x.B + x.D.transpose();
+    return read_coefficients(C, x.n, reads);
+}
+
+struct Kernel {
+    const char* name;
+    double (*run)(const Operands&, int reads);
+    double (*flops)(double n, int reads);
+    double (*bytes)(double n, int reads);
+};
+
+inline constexpr Kernel kKernels[] = {
+    // Per read: one n x n product (2n^3 FLOP) reading A, B and writing a temporary
+    {"example1_auto_product", example1_auto_product<MatrixXd>,
+     [](double n, int reads) { return reads * 2 * n * n * n; },
+     [](double n, int reads) { return reads * 24 * n * n; }},
+    {"example4_eval_product", example4_eval_product<MatrixXd>,
+     [](double n, int) { return 2 * n * n * n; },
+     [](double n, int) { return 24 * n * n; }},
+    // One product if read at all
+    {"example1_lazy_product", example1_lazy_product<MatrixXd>,
+     [](double n, int reads) { return reads > 0 ? 2 * n * n * n : 0.0; },
+     [](double n, int reads) { return reads > 0 ? 24 * n * n : 0.0; }},
+    // Per read: the product plus one addition of a coefficient of D
+    {"example7_auto_complex", example7_auto_complex<MatrixXd>,
+     [](double n, int reads) { return reads * (2 * n * n * n + 1); },
+     [](double n, int reads) { return reads * (24 * n * n + 8); }},
+    // Product plus n^2 additions; reads A, B, D and writes C
+    {"example7_eval_complex", example7_eval_complex<MatrixXd>,
+     [](double n, int) { return 2 * n * n * n + n * n; },
+     [](double n, int) { return 32 * n * n; }},
+};
+
+}  // namespace examples_benchmark
@@ -0,0 +1,465 @@
+// Benchmark of the examples.cpp patterns, with hardware counters per example.
+//
+// For every kernel in example_kernels.h and every matrix size, the kernel is
+// repeated until a batch takes at least --min-time seconds; the table shows
+// time per call and, where perf_event_open is permitted, cycles, IPC and
+// misses per thousand instructions (MPKI). High IPC with low MPKI means the
+// recomputation in the auto variants is compute-bound; rising LLC MPKI with
+// size means it has become memory-bound.
+//
+// Each kernel is measured in --repetitions batches; tables use the median time
+// per call, and --json writes every repetition so that two runs can be
+// compared statistically with python_env/bench_compare.py.
+//
+// --roofline first measures the machine's peak bandwidth and FLOP rate (see
+// roofline.h) and adds a table of achieved GFLOP/s and GB/s per kernel and
+// size against the attainable rate; --csv writes the same rows to a file.
+// The peaks are measured rather than theoretical, and are raised to the best
+// kernel's rate where a kernel exceeds them, so no row is above 100%.
+//
+// --latency instead times --samples single calls of every kernel at 3x3 and
+// 4x4, with dynamic (MatrixXd, heap) and fixed-size (stack) operands, and
+// prints percentiles and a histogram per variant (see latency.h). Heap
+// allocations of the dynamic auto and eval() variants show up in the tail.
+// Fixed-size rows also show the compile-time cost of the expression each
+// kernel declares (FLOP, bytes and depth, see include/eigen_auto/cost_model.h).
+//
+// Usage:
+//   ./examples_benchmark [--sizes 3,16,64,256] [--reads 2] [--min-time 0.2]
+//                        [--repetitions 10] [--json FILE]
+//                        [--no-counters] [--roofline] [--csv FILE]
+//   ./examples_benchmark --latency [--samples 100000] [--reads 2]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <eigen_auto/cost_model.h>
+
+#include "example_kernels.h"
+#include "latency.h"
+#include "perf_counters.h"
+#include "roofline.h"
+
+using namespace examples_benchmark;
+
+namespace {
+
+struct Options {
+    std::vector<Index> sizes = {3, 16, 64, 256};
+    int reads = 2;
+    double min_time = 0.2;
+    bool counters = true;
+    int repetitions = 10;
+    bool roofline = false;
+    const char* csv = nullptr;
+    const char* json = nullptr;
+    bool latency = false;
+    long samples = 100000;
+};
+
+// One kernel measured at one size
+struct Measurement {
+    const Kernel* kernel;
+    Index n;
+    // Calls per repetition
+    long iterations;
+    // Seconds per call of each repetition
+    std::vector<double> per_call;
+    // Counters summed over all repetitions
+    CounterSample sample;
+
+    double median_per_call() const {
+        std::vector<double> sorted = per_call;
+        std::sort(sorted.begin(), sorted.end());
+        const std::size_t middle = sorted.size() / 2;
+        return sorted.size() % 2 ? sorted[middle]
+                                 : (sorted[middle - 1] + sorted[middle]) / 2;
+    }
+
+    double total_calls() const {
+        return static_cast<double>(iterations) * static_cast<double>(per_call.size());
+    }
+};
+
+std::vector<Index> parse_sizes(const char* text) {
+    std::vector<Index> sizes;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        sizes.push_back(std::atol(item.c_str()));
+    }
+    return sizes;
+}
+
+bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--sizes") == 0 && has_value) {
+            options.sizes = parse_sizes(argv[++i]);
+        } else if (std::strcmp(argv[i], "--reads") == 0 && has_value) {
+            options.reads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && has_value) {
+            options.min_time = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--no-counters") == 0) {
+            options.counters = false;
+        } else if (std::strcmp(argv[i], "--repetitions") == 0 && has_value) {
+            options.repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--json") == 0 && has_value) {
+            options.json = argv[++i];
+        } else if (std::strcmp(argv[i], "--roofline") == 0) {
+            options.roofline = true;
+        } else if (std::strcmp(argv[i], "--csv") == 0 && has_value) {
+            options.csv = argv[++i];
+            options.roofline = true;
+        } else if (std::strcmp(argv[i], "--latency") == 0) {
+            options.latency = true;
+        } else if (std::strcmp(argv[i], "--samples") == 0 && has_value) {
+            options.samples = std::max(1L, std::atol(argv[++i]));
+        } else {
+            std::fprintf(stderr,
+                         "usage: %s [--sizes 3,16,64,256] [--reads N] "
+                         "[--min-time SECONDS] [--repetitions N] [--json FILE] "
+                         "[--no-counters] [--roofline] [--csv FILE]\n"
+                         "       %s --latency [--samples N] [--reads N]\n",
+                         argv[0], argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Keeps results alive so the compiler cannot drop the kernels
+volatile double g_sink = 0.0;
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// Number of calls for one batch to last about min_time seconds.
+long calibrate(const Kernel& kernel, const Operands& x, int reads, double min_time) {
+    long iterations = 1;
+    while (true) {
+        const auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < iterations; ++i) {
+            g_sink = g_sink + kernel.run(x, reads);
+        }
+        const double elapsed = seconds_since(start);
+        if (elapsed >= min_time / 4 || iterations >= (1L << 30)) {
+            return std::max(1L, static_cast<long>(iterations * min_time /
+                                                  std::max(elapsed, 1e-9)));
+        }
+        iterations *= 4;
+    }
+}
+
+void print_counter(const CounterSample& sample, std::size_t counter, double scale,
+                   const char* format) {
+    if (sample.valid[counter]) {
+        std::printf(format, sample.values[counter] * scale);
+    } else {
+        std::printf(" %12s", "n/a");
+    }
+}
+
+// Misses per thousand instructions
+void print_mpki(const CounterSample& sample, std::size_t counter) {
+    if (sample.valid[counter] && sample.valid[kInstructions] &&
+        sample.values[kInstructions] > 0) {
+        std::printf(" %10.2f",
+                    1000.0 * sample.values[counter] / sample.values[kInstructions]);
+    } else {
+        std::printf(" %10s", "n/a");
+    }
+}
+
+void print_counter_table(const std::vector<Measurement>& measurements) {
+    std::printf("%-24s %6s %12s %12s %10s %10s %10s %10s\n", "example", "n",
+                "ns/call", "cycles/call", "IPC", "L1D MPKI", "LLC MPKI",
+                "br MPKI");
+    for (const Measurement& m : measurements) {
+        const CounterSample& sample = m.sample;
+        std::printf("%-24s %6ld %12.1f", m.kernel->name, static_cast<long>(m.n),
+                    m.median_per_call() * 1e9);
+        print_counter(sample, kCycles, 1.0 / m.total_calls(), " %12.0f");
+        if (sample.valid[kCycles] && sample.valid[kInstructions] &&
+            sample.values[kCycles] > 0) {
+            std::printf(" %10.2f", sample.values[kInstructions] / sample.values[kCycles]);
+        } else {
+            std::printf(" %10s", "n/a");
+        }
+        print_mpki(sample, kL1dMisses);
+        print_mpki(sample, kLlcMisses);
+        print_mpki(sample, kBranchMisses);
+        std::printf("\n");
+    }
+}
+
+bool print_roofline(const std::vector<Measurement>& measurements, int reads,
+                    MachinePeaks peaks, const char* csv_path) {
+    for (const Measurement& m : measurements) {
+        const double n = static_cast<double>(m.n);
+        const double seconds = m.median_per_call();
+        raise_peaks(peaks, m.kernel->flops(n, reads) / seconds * 1e-9,
+                    m.kernel->bytes(n, reads) / seconds * 1e-9);
+    }
+
+    std::FILE* csv = nullptr;
+    if (csv_path) {
+        csv = std::fopen(csv_path, "w");
+        if (!csv) {
+            std::perror(csv_path);
+            return false;
+        }
+        std::fprintf(csv,
+                     "example,n,reads,seconds_per_call,flops,bytes,gflops,gbs,"
+                     "intensity,attainable_gflops,fraction_of_attainable,bound,"
+                     "peak_gflops,peak_gbs\n");
+    }
+
+    std::printf("\nRoofline (measured peak %.2f GFLOP/s%s, %.2f GB/s%s, ridge %.2f "
+                "FLOP/byte)\n",
+                peaks.gflops, peaks.gflops_raised ? " [from best kernel]" : "",
+                peaks.bandwidth_gbs, peaks.bandwidth_raised ? " [from best kernel]" : "",
+                peaks.gflops / peaks.bandwidth_gbs);
+    std::printf("Peaks are measured on this machine, not theoretical; a peak a "
+                "kernel exceeded is raised to that kernel's rate.\n");
+    std::printf("%-24s %6s %10s %10s %10s %11s %8s %7s\n", "example", "n", "GFLOP/s",
+                "GB/s", "FLOP/byte", "attainable", "% roof", "bound");
+    for (const Measurement& m : measurements) {
+        const double n = static_cast<double>(m.n);
+        const double flops = m.kernel->flops(n, reads);
+        const double bytes = m.kernel->bytes(n, reads);
+        const double seconds = m.median_per_call();
+        const RooflinePoint point = roofline_point(flops, bytes, seconds, peaks);
+        const char* bound = point.memory_bound ? "memory" : "compute";
+        // A lazy kernel that never reads does no work at all
+        const double fraction = point.attainable > 0 ? point.gflops / point.attainable : 0.0;
+        std::printf("%-24s %6ld %10.2f %10.2f %10.2f %11.2f %7.1f%% %7s\n",
+                    m.kernel->name, static_cast<long>(m.n), point.gflops, point.gbs,
+                    point.intensity, point.attainable, 100.0 * fraction, bound);
+        if (csv) {
+            std::fprintf(csv, "%s,%ld,%d,%.9g,%.9g,%.9g,%.6g,%.6g,%.6g,%.6g,%.6g,%s,%.6g,%.6g\n",
+                         m.kernel->name, static_cast<long>(m.n), reads, seconds, flops,
+                         bytes, point.gflops, point.gbs, point.intensity,
+                         point.attainable, fraction, bound,
+                         peaks.gflops, peaks.bandwidth_gbs);
+        }
+    }
+    if (csv) {
+        std::fclose(csv);
+    }
+    return true;
+}
+
+// Writes every repetition of every measurement for bench_compare.py.
+bool write_json(const char* path, const std::vector<Measurement>& measurements,
+                const Options& options) {
+    std::FILE* out = std::fopen(path, "w");
+    if (!out) {
+        std::perror(path);
+        return false;
+    }
+    char timestamp[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    std::fprintf(out, "{\n  \"context\": {\n");
+    std::fprintf(out, "    \"timestamp\": \"%s\",\n", timestamp);
+    std::fprintf(out, "    \"compiler\": \"%s\",\n", __VERSION__);
+    std::fprintf(out, "    \"eigen\": \"%d.%d.%d\",\n", EIGEN_WORLD_VERSION,
+                 EIGEN_MAJOR_VERSION, EIGEN_MINOR_VERSION);
+    std::fprintf(out, "    \"reads\": %d,\n", options.reads);
+    std::fprintf(out, "    \"min_time\": %g,\n", options.min_time);
+    std::fprintf(out, "    \"repetitions\": %d\n  },\n", options.repetitions);
+    std::fprintf(out, "  \"benchmarks\": [\n");
+    for (std::size_t i = 0; i < measurements.size(); ++i) {
+        const Measurement& m = measurements[i];
+        std::fprintf(out,
+                     "    {\"name\": \"%s/%ld\", \"example\": \"%s\", \"n\": %ld, "
+                     "\"iterations\": %ld, \"seconds_per_call\": [",
+                     m.kernel->name, static_cast<long>(m.n), m.kernel->name,
+                     static_cast<long>(m.n), m.iterations);
+        for (std::size_t r = 0; r < m.per_call.size(); ++r) {
+            std::fprintf(out, "%s%.9g", r ? ", " : "", m.per_call[r]);
+        }
+        std::fprintf(out, "]}%s\n", i + 1 < measurements.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+    return std::fclose(out) == 0;
+}
+
+// Compile-time cost of one evaluation of the expression a kernel declares
+struct ExpressionCost {
+    bool known = false;  // only for fixed sizes
+    std::size_t flops = 0;
+    std::size_t bytes = 0;
+    std::size_t depth = 0;
+};
+
+template <typename Expr>
+ExpressionCost expression_cost() {
+    ExpressionCost cost;
+    if constexpr (Expr::RowsAtCompileTime != Eigen::Dynamic &&
+                  Expr::ColsAtCompileTime != Eigen::Dynamic) {
+        cost = {true, eigen_auto::expression_flops<Expr>, eigen_auto::expression_bytes<Expr>,
+                eigen_auto::expression_depth<Expr>};
+    }
+    return cost;
+}
+
+// One kernel variant measured in --latency mode
+struct LatencyRow {
+    const char* name;
+    Index n;
+    const char* storage;
+    ExpressionCost cost;
+    LatencySamples samples;
+};
+
+template <typename Matrix>
+void measure_latency_variants(Index n, const char* storage, const Options& options,
+                              const TickClock& clock, std::vector<LatencyRow>& rows) {
+    const BasicOperands<Matrix> x(n);
+    const int reads = options.reads;
+    const ExpressionCost product = expression_cost<decltype(x.A * x.B)>();
+    const ExpressionCost complex = expression_cost<decltype(x.A * x.B + x.D.transpose())>();
+
+    using Run = double (*)(const BasicOperands<Matrix>&, int);
+    struct Variant {
+        const char* name;
+        Run run;
+        ExpressionCost cost;
+    };
+    const Variant variants[] = {
+        {"example1_auto_product", example1_auto_product<Matrix>, product},
+        {"example4_eval_product", example4_eval_product<Matrix>, product},
+        {"example1_lazy_product", example1_lazy_product<Matrix>, product},
+        {"example7_auto_complex", example7_auto_complex<Matrix>, complex},
+        {"example7_eval_complex", example7_eval_complex<Matrix>, complex},
+    };
+    for (const Variant& variant : variants) {
+        const Run run = variant.run;
+        rows.push_back({variant.name, n, storage, variant.cost,
+                        measure_latency([&] { g_sink = g_sink + run(x, reads); }, clock,
+                                        options.samples)});
+    }
+}
+
+template <int N>
+void measure_latency_size(const Options& options, const TickClock& clock,
+                          std::vector<LatencyRow>& rows) {
+    using Fixed = Eigen::Matrix<double, N, N>;
+    // The compile-time model agrees with the kernel table's FLOP count
+    static_assert(eigen_auto::expression_flops<decltype(Fixed() * Fixed())> == 2 * N * N * N);
+
+    measure_latency_variants<MatrixXd>(N, "dynamic", options, clock, rows);
+    measure_latency_variants<Fixed>(N, "fixed", options, clock, rows);
+}
+
+void print_latency(std::vector<LatencyRow>& rows, const TickClock& clock,
+                   const Options& options) {
+    // Dynamic and fixed-size variants of one kernel next to each other
+    std::stable_sort(rows.begin(), rows.end(), [](const LatencyRow& a, const LatencyRow& b) {
+        return a.n != b.n ? a.n < b.n : std::strcmp(a.name, b.name) < 0;
+    });
+
+    std::printf("Latency per call in ns, %ld calls each (clock overhead %.1f ns "
+                "subtracted)\n",
+                options.samples, static_cast<double>(clock.overhead) * clock.ns_per_tick);
+    std::printf("%-24s %3s %-8s %6s %6s %5s %9s %9s %9s %9s %9s %9s %9s\n", "example",
+                "n", "storage", "FLOP", "bytes", "depth", "mean", "p50", "p90", "p99",
+                "p99.9", "p99.99", "max");
+    for (const LatencyRow& row : rows) {
+        const LatencySamples& s = row.samples;
+        std::printf("%-24s %3ld %-8s", row.name, static_cast<long>(row.n), row.storage);
+        if (row.cost.known) {
+            std::printf(" %6zu %6zu %5zu", row.cost.flops, row.cost.bytes, row.cost.depth);
+        } else {
+            std::printf(" %6s %6s %5s", "-", "-", "-");
+        }
+        std::printf(" %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", s.mean(),
+                    s.percentile(50), s.percentile(90), s.percentile(99),
+                    s.percentile(99.9), s.percentile(99.99), s.ns.back());
+    }
+    for (const LatencyRow& row : rows) {
+        std::printf("\n%s n=%ld %s\n", row.name, static_cast<long>(row.n), row.storage);
+        print_latency_histogram(row.samples);
+    }
+}
+
+int run_latency(const Options& options) {
+    const TickClock clock = calibrate_tick_clock();
+    std::vector<LatencyRow> rows;
+    measure_latency_size<3>(options, clock, rows);
+    measure_latency_size<4>(options, clock, rows);
+    print_latency(rows, clock, options);
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        return 2;
+    }
+    if (options.latency) {
+        return run_latency(options);
+    }
+
+    PerfCounters counters;
+    const bool use_counters = options.counters && counters.available();
+    if (options.counters && !counters.unavailable_reason().empty()) {
+        std::fprintf(stderr, "Note: hardware counters %s: %s\n",
+                     counters.available() ? "partly unavailable" : "unavailable",
+                     counters.unavailable_reason().c_str());
+    }
+
+    MachinePeaks peaks;
+    if (options.roofline) {
+        peaks = measure_machine_peaks();
+    }
+
+    std::vector<Measurement> measurements;
+    for (Index n : options.sizes) {
+        const Operands x(n);
+        for (const Kernel& kernel : kKernels) {
+            const long iterations = calibrate(kernel, x, options.reads, options.min_time);
+
+            Measurement m{&kernel, n, iterations, {}, {}};
+            if (use_counters) {
+                counters.start();
+            }
+            for (int r = 0; r < options.repetitions; ++r) {
+                const auto start = std::chrono::steady_clock::now();
+                for (long i = 0; i < iterations; ++i) {
+                    g_sink = g_sink + kernel.run(x, options.reads);
+                }
+                m.per_call.push_back(seconds_since(start) / iterations);
+            }
+            if (use_counters) {
+                m.sample = counters.stop();
+            }
+            measurements.push_back(m);
+        }
+    }
+
+    print_counter_table(measurements);
+    if (options.roofline &&
+        !print_roofline(measurements, options.reads, peaks, options.csv)) {
+        return 1;
+    }
+    if (options.json && !write_json(options.json, measurements, options)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+// Per-call latency measurement for the --latency mode of examples_benchmark.
+//
+// Throughput batches hide what a control loop sees: one slow call in a
+// thousand. Here every call is timed on its own, so the clock must cost far
+// less than a 3x3 product. On x86 it is the time-stamp counter read between
+// lfences (tens of cycles), converted to nanoseconds with a rate calibrated
+// against steady_clock; this assumes an invariant TSC, which every x86 CPU of
+// the last decade has. Elsewhere steady_clock is used directly.
+//
+// The smallest back-to-back clock reading is subtracted from every sample, so
+// the percentiles are those of the kernel, not of kernel plus clock.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define EXAMPLES_BENCHMARK_HAVE_TSC 1
+#include <x86intrin.h>
+#else
+#define EXAMPLES_BENCHMARK_HAVE_TSC 0
+#endif
+
+namespace examples_benchmark {
+
+// Reads the low-overhead clock, in ticks.
+inline std::uint64_t read_ticks() {
+#if EXAMPLES_BENCHMARK_HAVE_TSC
+    // The fences keep the kernel's loads from moving across the reading
+    _mm_lfence();
+    const std::uint64_t ticks = __rdtsc();
+    _mm_lfence();
+    return ticks;
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+#endif
+}
+
+struct TickClock {
+    double ns_per_tick = 1.0;
+    // Smallest cost of two back-to-back readings, in ticks
+    std::uint64_t overhead = 0;
+};
+
+// Calibrates the tick rate over about `seconds` and measures the overhead.
+inline TickClock calibrate_tick_clock(double seconds = 0.05) {
+    TickClock clock;
+#if EXAMPLES_BENCHMARK_HAVE_TSC
+    const auto start_time = std::chrono::steady_clock::now();
+    const std::uint64_t start_ticks = read_ticks();
+    double elapsed = 0.0;
+    while (elapsed < seconds) {
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                start_time)
+                      .count();
+    }
+    clock.ns_per_tick = elapsed * 1e9 / static_cast<double>(read_ticks() - start_ticks);
+#else
+    (void)seconds;
+#endif
+    std::uint64_t overhead = ~std::uint64_t(0);
+    for (int i = 0; i < 10000; ++i) {
+        const std::uint64_t first = read_ticks();
+        overhead = std::min(overhead, read_ticks() - first);
+    }
+    clock.overhead = overhead;
+    return clock;
+}
+
+// Latencies of the individual calls of one kernel, in nanoseconds, sorted.
+struct LatencySamples {
+    std::vector<double> ns;
+
+    // Nearest-rank percentile, p in [0, 100]
+    double percentile(double p) const {
+        if (ns.empty()) {
+            return 0.0;
+        }
+        const double rank = std::ceil(p / 100.0 * static_cast<double>(ns.size()));
+        const std::size_t index = static_cast<std::size_t>(std::max(rank, 1.0)) - 1;
+        return ns[std::min(index, ns.size() - 1)];
+    }
+
+    double mean() const {
+        double sum = 0.0;
+        for (double value : ns) {
+            sum += value;
+        }
+        return ns.empty() ? 0.0 : sum / static_cast<double>(ns.size());
+    }
+};
+
+// Times `samples` single calls of body() after `warmup` untimed ones.
+template <typename Body>
+LatencySamples measure_latency(Body body, const TickClock& clock, long samples,
+                               long warmup = 1000) {
+    for (long i = 0; i < warmup; ++i) {
+        body();
+    }
+    std::vector<std::uint64_t> ticks(static_cast<std::size_t>(samples));
+    for (std::uint64_t& t : ticks) {
+        const std::uint64_t start = read_ticks();
+        body();
+        t = read_ticks() - start;
+    }
+
+    LatencySamples result;
+    result.ns.reserve(ticks.size());
+    for (std::uint64_t t : ticks) {
+        const std::uint64_t net = t > clock.overhead ? t - clock.overhead : 0;
+        result.ns.push_back(static_cast<double>(net) * clock.ns_per_tick);
+    }
+    std::sort(result.ns.begin(), result.ns.end());
+    return result;
+}
+
+// Prints a histogram with power-of-two nanosecond buckets from the fastest to
+// the slowest call. Counts are printed next to the bars because the tail
+// buckets that matter hold too few calls to show up in a linear bar.
+inline void print_latency_histogram(const LatencySamples& samples, long width = 40) {
+    if (samples.ns.empty()) {
+        return;
+    }
+    const int first = static_cast<int>(std::floor(std::log2(std::max(samples.ns.front(), 1.0))));
+    const int last = static_cast<int>(std::floor(std::log2(std::max(samples.ns.back(), 1.0))));
+    std::vector<long> counts(static_cast<std::size_t>(last - first + 1), 0);
+    for (double value : samples.ns) {
+        const int bucket = static_cast<int>(std::floor(std::log2(std::max(value, 1.0))));
+        ++counts[static_cast<std::size_t>(bucket - first)];
+    }
+    const long peak = *std::max_element(counts.begin(), counts.end());
+    for (std::size_t b = 0; b < counts.size(); ++b) {
+        const double low = std::ldexp(1.0, first + static_cast<int>(b));
+        // Non-empty buckets get at least one mark
+        const long bar = counts[b] > 0 ? std::max(1L, width * counts[b] / peak) : 0;
+        std::printf("  %9.0f - %9.0f ns %9ld%s%s\n", low, 2 * low, counts[b],
+                    bar > 0 ? " " : "",
+                    std::string(static_cast<std::size_t>(bar), '#').c_str());
+    }
+}
+
+}  // namespace examples_benchmark
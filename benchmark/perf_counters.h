@@ -0,0 +1,184 @@
+// Hardware performance counters around a measured region, via perf_event_open(2).
+//
+// Every counter is opened on its own rather than as one group, so that a
+// counter the CPU or hypervisor does not expose (LLC misses are often missing
+// in VMs) only blanks its own column. Values are scaled by
+// time_enabled / time_running when the kernel had to multiplex counters.
+//
+// Containers usually forbid perf_event_open (seccomp, or
+// kernel.perf_event_paranoid > 2). PerfCounters then reports itself
+// unavailable with the reason, and callers print "n/a" instead of failing.
+// Building with EXAMPLES_BENCHMARK_PERF_COUNTERS=0 or on a non-Linux system
+// compiles the same interface without any counters.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifndef EXAMPLES_BENCHMARK_PERF_COUNTERS
+#define EXAMPLES_BENCHMARK_PERF_COUNTERS 1
+#endif
+
+#if EXAMPLES_BENCHMARK_PERF_COUNTERS && defined(__linux__)
+#define EXAMPLES_BENCHMARK_HAVE_PERF 1
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#define EXAMPLES_BENCHMARK_HAVE_PERF 0
+#endif
+
+namespace examples_benchmark {
+
+enum Counter : std::size_t {
+    kCycles,
+    kInstructions,
+    kL1dMisses,
+    kLlcMisses,
+    kBranchMisses,
+    kCounterCount
+};
+
+inline const char* counter_name(std::size_t counter) {
+    static const char* const names[kCounterCount] = {
+        "cycles", "instructions", "l1d-misses", "llc-misses", "branch-misses"};
+    return names[counter];
+}
+
+// Counter values of one measured region; valid[i] is false for counters that
+// could not be opened.
+struct CounterSample {
+    std::array<double, kCounterCount> values{};
+    std::array<bool, kCounterCount> valid{};
+};
+
+class PerfCounters {
+public:
+    PerfCounters() {
+#if EXAMPLES_BENCHMARK_HAVE_PERF
+        for (std::size_t i = 0; i < kCounterCount; ++i) {
+            fds_[i] = open_counter(i);
+            if (fds_[i] >= 0) {
+                available_ = true;
+            } else if (reason_.empty()) {
+                reason_ = std::string("perf_event_open(") + counter_name(i) +
+                          "): " + std::strerror(errno);
+            }
+        }
+        if (!available_ && reason_.empty()) {
+            reason_ = "no counters could be opened";
+        }
+#else
+        reason_ = "built without perf_event_open support";
+#endif
+    }
+
+    ~PerfCounters() {
+#if EXAMPLES_BENCHMARK_HAVE_PERF
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // True if at least one counter could be opened.
+    bool available() const { return available_; }
+
+    // Why counters are (partly) unavailable; empty if all were opened.
+    const std::string& unavailable_reason() const { return reason_; }
+
+    void start() {
+#if EXAMPLES_BENCHMARK_HAVE_PERF
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    CounterSample stop() {
+        CounterSample sample;
+#if EXAMPLES_BENCHMARK_HAVE_PERF
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+        for (std::size_t i = 0; i < kCounterCount; ++i) {
+            // value, time_enabled, time_running
+            std::uint64_t data[3] = {};
+            if (fds_[i] < 0 || read(fds_[i], data, sizeof(data)) != sizeof(data)) {
+                continue;
+            }
+            if (data[2] == 0) {
+                continue;  // never scheduled onto the PMU
+            }
+            sample.values[i] = static_cast<double>(data[0]) *
+                               static_cast<double>(data[1]) /
+                               static_cast<double>(data[2]);
+            sample.valid[i] = true;
+        }
+#endif
+        return sample;
+    }
+
+private:
+#if EXAMPLES_BENCHMARK_HAVE_PERF
+    static int open_counter(std::size_t counter) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format =
+            PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        switch (counter) {
+            case kCycles:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case kInstructions:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case kL1dMisses:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_L1D |
+                              (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+            case kLlcMisses:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_LL |
+                              (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+            default:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+        }
+        // This thread only, on any CPU
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    std::array<int, kCounterCount> fds_{};
+#endif
+    bool available_ = false;
+    std::string reason_;
+};
+
+}  // namespace examples_benchmark
@@ -0,0 +1,156 @@
+// Machine peaks for the roofline report of examples_benchmark.
+//
+// The peaks are measured with the same compiler flags as the kernels, so
+// they are what Eigen code in this build can reach, not the datasheet values:
+//
+// - bandwidth: STREAM triad a = b + s * c over arrays far larger than the
+//   last-level cache, counting 24 bytes per element as STREAM does;
+// - FLOP rate: independent multiply-add chains of Eigen packets held in
+//   registers, so they use the same SIMD width as the kernels and fused
+//   multiply-add where the build enables it (__FMA__).
+//
+// A measured peak can still be beaten by a kernel (e.g. turbo frequency,
+// or data resident in cache above the DRAM bandwidth), so the report raises
+// each peak to the best rate any kernel reached: see raise_peaks().
+
+#pragma once
+
+#include <Eigen/Core>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace examples_benchmark {
+
+struct MachinePeaks {
+    double bandwidth_gbs = 0.0;
+    double gflops = 0.0;
+    // Set by raise_peaks() when a kernel beat the measured value
+    bool bandwidth_raised = false;
+    bool gflops_raised = false;
+};
+
+// Raises the peaks to rates a kernel actually reached, so that no kernel lies
+// above its attainable rate.
+inline void raise_peaks(MachinePeaks& peaks, double gflops, double gbs) {
+    if (gflops > peaks.gflops) {
+        peaks.gflops = gflops;
+        peaks.gflops_raised = true;
+    }
+    if (gbs > peaks.bandwidth_gbs) {
+        peaks.bandwidth_gbs = gbs;
+        peaks.bandwidth_raised = true;
+    }
+}
+
+// Roofline of one kernel at one size.
+struct RooflinePoint {
+    double gflops = 0.0;
+    double gbs = 0.0;
+    double intensity = 0.0;    // FLOP per byte
+    double attainable = 0.0;   // min(peak FLOP rate, intensity * peak bandwidth)
+    bool memory_bound = false;
+};
+
+inline RooflinePoint roofline_point(double flops, double bytes, double seconds,
+                                    const MachinePeaks& peaks) {
+    RooflinePoint point;
+    point.gflops = flops / seconds * 1e-9;
+    point.gbs = bytes / seconds * 1e-9;
+    point.intensity = bytes > 0 ? flops / bytes : 0.0;
+    const double bandwidth_limit = point.intensity * peaks.bandwidth_gbs;
+    point.memory_bound = bandwidth_limit < peaks.gflops;
+    point.attainable = std::min(peaks.gflops, bandwidth_limit);
+    return point;
+}
+
+namespace detail {
+
+template <typename Body>
+double best_seconds(Body body, int repetitions) {
+    double best = 1e300;
+    for (int r = 0; r < repetitions; ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        body();
+        best = std::min(
+            best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                      .count());
+    }
+    return best;
+}
+
+// One multiply-add on each chain; the index pack unrolls the chains so that
+// they stay in registers.
+template <typename Packet, std::size_t... I>
+EIGEN_STRONG_INLINE void madd_chains(Packet* acc, const Packet& scale,
+                                     const Packet& offset, std::index_sequence<I...>) {
+    ((acc[I] = Eigen::internal::pmadd(acc[I], scale, offset)), ...);
+}
+
+}  // namespace detail
+
+// STREAM triad over three arrays of `elements` doubles (default 3 x 32 MiB).
+inline double measure_peak_bandwidth(std::size_t elements = std::size_t(1) << 22,
+                                     int repetitions = 5) {
+    std::vector<double> a(elements, 0.0), b(elements, 1.0), c(elements, 2.0);
+    const double scalar = 3.0;
+    const double seconds = detail::best_seconds(
+        [&] {
+            for (std::size_t i = 0; i < elements; ++i) {
+                a[i] = b[i] + scalar * c[i];
+            }
+        },
+        repetitions);
+    volatile double sink = a[elements / 2];
+    (void)sink;
+    return 24.0 * static_cast<double>(elements) / seconds * 1e-9;
+}
+
+// Multiply-add throughput with enough independent chains to hide latency.
+inline double measure_peak_gflops(long iterations = 1L << 23, int repetitions = 5) {
+    using Packet = Eigen::internal::packet_traits<double>::type;
+    constexpr int kPacketSize = Eigen::internal::packet_traits<double>::size;
+    // Covers FMA latency times issue ports (e.g. 4 cycles x 2 ports) with
+    // room to spare, within the 16 vector registers of x86-64
+    constexpr std::size_t kChains = 12;
+    Packet acc[kChains];
+    for (std::size_t c = 0; c < kChains; ++c) {
+        acc[c] = Eigen::internal::pset1<Packet>(1.0 + 0.01 * static_cast<double>(c));
+    }
+    const Packet scale = Eigen::internal::pset1<Packet>(0.999999);
+    const Packet offset = Eigen::internal::pset1<Packet>(1e-7);
+    const double seconds = detail::best_seconds(
+        [&] {
+            // Locals, not the captured array: stores through the capture
+            // would put a memory round trip into every chain
+            Packet chains[kChains];
+            std::copy(acc, acc + kChains, chains);
+            const Packet s = scale;
+            const Packet o = offset;
+            for (long i = 0; i < iterations; ++i) {
+                detail::madd_chains(chains, s, o, std::make_index_sequence<kChains>());
+            }
+            std::copy(chains, chains + kChains, acc);
+        },
+        repetitions);
+    double sum = 0.0;
+    for (std::size_t c = 0; c < kChains; ++c) {
+        sum += Eigen::internal::predux(acc[c]);
+    }
+    volatile double sink = sum;
+    (void)sink;
+    return 2.0 * kChains * kPacketSize * static_cast<double>(iterations) /
+           seconds * 1e-9;
+}
+
+inline MachinePeaks measure_machine_peaks() {
+    MachinePeaks peaks;
+    peaks.bandwidth_gbs = measure_peak_bandwidth();
+    peaks.gflops = measure_peak_gflops();
+    return peaks;
+}
+
+}  // namespace examples_benchmark
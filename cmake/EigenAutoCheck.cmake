@@ -0,0 +1,94 @@
+# Build-system integration of python_env/eigen_auto_check.py
+#
+#   eigen_auto_check_target(<target> [WERROR] [CHECKS <filter>])
+#
+# Adds one custom command per C++ source of <target> that checks the source
+# and writes a stamp plus a depfile listing every header the translation unit
+# included. Make and Ninja therefore re-run a check only when its source, one
+# of its headers, compile_commands.json or the checker itself changed. The
+# stamps are collected in the target <target>_eigen_auto_check, which is
+# built by default but does not depend on <target>, so checks run in parallel
+# with compilation.
+#
+# Findings are reported as warnings and do not fail the build unless WERROR
+# is given. CHECKS is passed to --checks.
+#
+# The checker needs a Python interpreter with libclang; set
+# EIGEN_AUTO_CHECK_PYTHON (e.g. to python_env/.venv/bin/python) if the
+# default Python3 interpreter does not have it.
+
+set(EIGEN_AUTO_CHECK_DIR "${CMAKE_CURRENT_LIST_DIR}/../python_env")
+get_filename_component(EIGEN_AUTO_CHECK_DIR "${EIGEN_AUTO_CHECK_DIR}" ABSOLUTE)
+
+set(EIGEN_AUTO_CHECK_PYTHON "" CACHE FILEPATH
+    "Python interpreter with libclang used by eigen_auto_check_target() (default: Python3)")
+
+function(eigen_auto_check_target target)
+    cmake_parse_arguments(PARSE_ARGV 1 ARG "WERROR" "CHECKS" "")
+
+    set(python "${EIGEN_AUTO_CHECK_PYTHON}")
+    if(NOT python)
+        find_package(Python3 3.13 REQUIRED COMPONENTS Interpreter)
+        set(python "${Python3_EXECUTABLE}")
+    endif()
+
+    set(options)
+    if(NOT ARG_WERROR)
+        list(APPEND options --exit-zero)
+    endif()
+    if(ARG_CHECKS)
+        list(APPEND options "--checks=${ARG_CHECKS}")
+    endif()
+
+    # Editing the checker, or any module it imports, invalidates every stamp
+    file(GLOB checker_sources CONFIGURE_DEPENDS "${EIGEN_AUTO_CHECK_DIR}/*.py")
+
+    # Makefile generators support DEPFILE from CMake 3.20 on
+    set(use_depfile ON)
+    if(CMAKE_VERSION VERSION_LESS 3.20 AND NOT CMAKE_GENERATOR MATCHES "Ninja")
+        message(WARNING "eigen_auto_check_target(${target}): CMake ${CMAKE_VERSION} "
+                        "cannot use depfiles with ${CMAKE_GENERATOR}; header changes "
+                        "will not re-run the checker")
+        set(use_depfile OFF)
+    endif()
+
+    get_target_property(sources ${target} SOURCES)
+    get_target_property(source_dir ${target} SOURCE_DIR)
+    set(stamps)
+    foreach(source IN LISTS sources)
+        if(source MATCHES "^\\$<" OR NOT source MATCHES "\\.(cpp|cc|cxx|C)$")
+            continue()
+        endif()
+        get_filename_component(path "${source}" ABSOLUTE BASE_DIR "${source_dir}")
+        file(RELATIVE_PATH relative "${CMAKE_SOURCE_DIR}" "${path}")
+        string(REPLACE "../" "__/" relative "${relative}")
+
+        set(stamp "${CMAKE_CURRENT_BINARY_DIR}/eigen_auto_check/${target}/${relative}.stamp")
+        set(depfile_args)
+        set(depfile_options)
+        if(use_depfile)
+            set(depfile_args DEPFILE "${stamp}.d")
+            set(depfile_options --depfile "${stamp}.d")
+        endif()
+
+        # Depfile paths are absolute, so let Ninja take them as they are
+        cmake_policy(PUSH)
+        if(POLICY CMP0116)
+            cmake_policy(SET CMP0116 NEW)
+        endif()
+        add_custom_command(
+            OUTPUT "${stamp}"
+            COMMAND "${python}" "${EIGEN_AUTO_CHECK_DIR}/eigen_auto_check.py"
+                    "${path}" "${CMAKE_BINARY_DIR}"
+                    --stamp "${stamp}" ${depfile_options} ${options}
+            DEPENDS "${path}" "${CMAKE_BINARY_DIR}/compile_commands.json" ${checker_sources}
+            ${depfile_args}
+            COMMENT "Checking ${relative} for auto with Eigen expressions"
+            VERBATIM
+        )
+        cmake_policy(POP)
+        list(APPEND stamps "${stamp}")
+    endforeach()
+
+    add_custom_target(${target}_eigen_auto_check ALL DEPENDS ${stamps})
+endfunction()
@@ -1,4 +1,10 @@
+// Checker budget for parse+analysis of this file: [budget: time=10s memory=512MiB]
+#define EIGEN_USE_THREADS
 #include <Eigen/Dense>
+#include <unsupported/Eigen/CXX11/Tensor>
+#include <eigen_auto/concepts.h>
+#include <eigen_auto/lazy_eval.h>
+#include <array>
 #include <iostream>
 
 using namespace Eigen;
@@ -8,7 +14,7 @@ void example1_repeated_evaluation() {
     MatrixXd A = MatrixXd::Random(3, 3);
     MatrixXd B = MatrixXd::Random(3, 3);
 
-    auto C = A * B;  // Deduces Eigen::Product<...>, not MatrixXd
+    auto C = A * B;  // Deduces Eigen::Product<...>, not MatrixXd [expect: eigen-auto Eigen::Product]
 
     // Each access to C recomputes A*B
     std::cout << "C(0,0): " << C(0, 0) << std::endl;
@@ -20,7 +26,7 @@ void example1b_const_auto() {
     MatrixXd A = MatrixXd::Random(3, 3);
     MatrixXd B = MatrixXd::Random(3, 3);
 
-    const auto C = A * B;  // Deduces const Eigen::Product<...>
+    const auto C = A * B;  // Deduces const Eigen::Product<...> [expect: eigen-auto Eigen::Product]
 
     std::cout << "C(0,0): " << C(0, 0) << std::endl;
 }
@@ -30,7 +36,7 @@ void example1c_const_auto_ref() {
     MatrixXd A = MatrixXd::Random(3, 3);
     MatrixXd B = MatrixXd::Random(3, 3);
 
-    const auto& C = A * B;  // Deduces const Eigen::Product<...> &
+    const auto& C = A * B;  // Deduces const Eigen::Product<...> & [expect: eigen-auto Eigen::Product]
 
     std::cout << "C(0,0): " << C(0, 0) << std::endl;
 }
@@ -40,7 +46,7 @@ void example2_stale_references() {
     MatrixXd A = MatrixXd::Random(3, 3);
     MatrixXd B = MatrixXd::Random(3, 3);
 
-    auto C = A * B;  // Deduces Eigen::Product<...> - stores references to A and B
+    auto C = A * B;  // Deduces Eigen::Product<...> - stores references to A and B [expect: eigen-auto Eigen::Product]
 
     std::cout << "Before: " << C(0, 0) << std::endl;
     A(0, 0) = 999.0;  // Modifying A changes C's result!
@@ -52,7 +58,7 @@ void example3_dangling_reference() {
     MatrixXd A = MatrixXd::Random(3, 3);
     MatrixXd B = MatrixXd::Random(3, 3);
 
-    auto C = ((A + B).eval()).transpose();  // Deduces Eigen::Transpose<...>
+    auto C = ((A + B).eval()).transpose();  // Deduces Eigen::Transpose<...> [expect: eigen-auto Eigen::Transpose]
 
     // Accessing C is undefined behavior - segfault risk
     // std::cout << C(0, 0) << std::endl;
@@ -63,7 +69,7 @@ void example3b_const_auto_dangling() {
     MatrixXd A = MatrixXd::Random(3, 3);
     MatrixXd B = MatrixXd::Random(3, 3);
 
-    const auto C = ((A + B).eval()).transpose();  // Deduces const Eigen::Transpose<...>
+    const auto C = ((A + B).eval()).transpose();  // Deduces const Eigen::Transpose<...> [expect: eigen-auto Eigen::Transpose]
 
     // std::cout << C(0, 0) << std::endl;
 }
@@ -73,7 +79,7 @@ void example3c_const_auto_ref_dangling() {
     MatrixXd A = MatrixXd::Random(3, 3);
     MatrixXd B = MatrixXd::Random(3, 3);
 
-    const auto& C = ((A + B).eval()).transpose();  // Deduces const Eigen::Transpose<...> &
+    const auto& C = ((A + B).eval()).transpose();  // Deduces const Eigen::Transpose<...> & [expect: eigen-auto Eigen::Transpose]
 
     // std::cout << C(0, 0) << std::endl;
 }
@@ -151,7 +157,7 @@ void example7_complex_expression() {
     MatrixXd B = MatrixXd::Random(3, 3);
     MatrixXd D = MatrixXd::Random(3, 3);
 
-    auto C = A * B + D.transpose();  // Deduces Eigen::CwiseBinaryOp<...>
+    auto C = A * B + D.transpose();  // Deduces Eigen::CwiseBinaryOp<...> [expect: eigen-auto Eigen::CwiseBinaryOp]
 
     std::cout << "C(0,0): " << C(0, 0) << std::endl;
 }
@@ -162,7 +168,7 @@ void example7b_const_auto_complex() {
     MatrixXd B = MatrixXd::Random(3, 3);
     MatrixXd D = MatrixXd::Random(3, 3);
 
-    const auto C = A * B + D.transpose();  // Deduces const Eigen::CwiseBinaryOp<...>
+    const auto C = A * B + D.transpose();  // Deduces const Eigen::CwiseBinaryOp<...> [expect: eigen-auto Eigen::CwiseBinaryOp]
 
     std::cout << "C(0,0): " << C(0, 0) << std::endl;
 }
@@ -173,7 +179,7 @@ void example7c_const_auto_ref_complex() {
     MatrixXd B = MatrixXd::Random(3, 3);
     MatrixXd D = MatrixXd::Random(3, 3);
 
-    const auto& C = A * B + D.transpose();  // Deduces const Eigen::CwiseBinaryOp<...> &
+    const auto& C = A * B + D.transpose();  // Deduces const Eigen::CwiseBinaryOp<...> & [expect: eigen-auto Eigen::CwiseBinaryOp]
 
     std::cout << "C(0,0): " << C(0, 0) << std::endl;
 }
@@ -184,7 +190,7 @@ void example8_vector_normalized() {
     VectorXd v = VectorXd::Random(3);
     VectorXd u = VectorXd::Random(3);
 
-    auto C = u + (A * v).normalized();  // Deduces Eigen::CwiseBinaryOp<...>
+    auto C = u + (A * v).normalized();  // Deduces Eigen::CwiseBinaryOp<...> [expect: eigen-auto Eigen::CwiseBinaryOp]
 
     std::cout << "C(0): " << C(0) << std::endl;
 }
@@ -194,7 +200,7 @@ void example9_decltype_auto() {
     MatrixXd A = MatrixXd::Random(3, 3);
     MatrixXd B = MatrixXd::Random(3, 3);
 
-    decltype(auto) C = A * B;  // Deduces Eigen::Product<...>
+    decltype(auto) C = A * B;  // Deduces Eigen::Product<...> [expect: eigen-auto Eigen::Product]
 
     std::cout << "C(0,0): " << C(0, 0) << std::endl;
 }
@@ -204,7 +210,7 @@ void example10_auto_ref() {
     MatrixXd A = MatrixXd::Random(3, 3);
     MatrixXd B = MatrixXd::Random(3, 3);
 
-    const auto& C = A * B;  // Deduces const Eigen::Product<...> &
+    const auto& C = A * B;  // Deduces const Eigen::Product<...> & [expect: eigen-auto Eigen::Product]
 
     std::cout << "C(0,0): " << C(0, 0) << std::endl;
 }
@@ -234,7 +240,7 @@ void example_multiline1_expression_template() {
     MatrixXd B = MatrixXd::Random(3, 3);
     MatrixXd D = MatrixXd::Random(3, 3);
 
-    auto C = A * B +
+    auto C = A * B +  // [expect: eigen-auto Eigen::CwiseBinaryOp]
              D.transpose();  // Deduces Eigen::CwiseBinaryOp<...>
 
     std::cout << "C(0,0): " << C(0, 0) << std::endl;
@@ -259,7 +265,7 @@ void example_multiline3_complex_expression() {
     MatrixXd D = MatrixXd::Random(3, 3);
     MatrixXd E = MatrixXd::Random(3, 3);
 
-    auto C = A * B +
+    auto C = A * B +  // [expect: eigen-auto Eigen::CwiseBinaryOp]
              D.transpose() *
              E;  // Deduces Eigen::CwiseBinaryOp<...>
 
@@ -272,7 +278,7 @@ void example_multiline4_parenthesized() {
     MatrixXd B = MatrixXd::Random(3, 3);
     MatrixXd D = MatrixXd::Random(3, 3);
 
-    auto C = (
+    auto C = (  // [expect: eigen-auto Eigen::CwiseBinaryOp]
         A * B +
         D.transpose()
     );  // Deduces Eigen::CwiseBinaryOp<...>
@@ -280,6 +286,110 @@ void example_multiline4_parenthesized() {
     std::cout << "C(0,0): " << C(0, 0) << std::endl;
 }
 
+// ============================================================================
+// Conditional use: lazy on purpose
+// ============================================================================
+
+void example17_conditional_auto(bool verbose) {
+    // Deduces expression template type - read only on one path, recomputed per read
+    MatrixXd A = MatrixXd::Random(3, 3);
+    MatrixXd B = MatrixXd::Random(3, 3);
+
+    auto C = A * B;  // Deduces Eigen::Product<...> [expect: eigen-auto Eigen::Product]
+
+    if (verbose) {
+        std::cout << "C(0,0): " << C(0, 0) << std::endl;
+        std::cout << "C(1,1): " << C(1, 1) << std::endl;
+    }
+}
+
+void example17b_lazy_eval(bool verbose) {
+    // Deduces eigen_auto::lazy_eval<...> - A*B computed once, only if read
+    MatrixXd A = MatrixXd::Random(3, 3);
+    MatrixXd B = MatrixXd::Random(3, 3);
+
+    auto C = eigen_auto::lazy_eval(A * B);  // Not an Eigen type
+
+    if (verbose) {
+        std::cout << "C(0,0): " << C(0, 0) << std::endl;
+        std::cout << "C(1,1): " << C(1, 1) << std::endl;
+    }
+}
+
+// ============================================================================
+// Constrained auto: the compiler enforces the rule
+// ============================================================================
+
+void example18_constrained_auto() {
+    // Deduces plain matrix type - EigenPlain rejects expression templates
+    MatrixXd A = MatrixXd::Random(3, 3);
+    MatrixXd B = MatrixXd::Random(3, 3);
+
+    eigen_auto::EigenPlain auto C = (A * B).eval();  // Deduces Eigen::Matrix<double, -1, -1>
+    // eigen_auto::EigenPlain auto D = A * B;  // error: Product<...> does not satisfy EigenPlain
+
+    std::cout << "C(0,0): " << C(0, 0) << std::endl;
+}
+
+// ============================================================================
+// Tensor module: same expression templates, plus a choice of device
+// ============================================================================
+
+using Tensor2d = Eigen::Tensor<double, 2>;
+// 2 * 128^3 FLOPs per product: worth a thread pool
+using LargeTensor = Eigen::TensorFixedSize<double, Eigen::Sizes<128, 128>>;
+// 2 * 4^3 FLOPs per product: a thread pool would only add overhead
+using SmallTensor = Eigen::TensorFixedSize<double, Eigen::Sizes<4, 4>>;
+using ContractionDims = std::array<Eigen::IndexPair<int>, 1>;
+
+void example19_tensor_auto() {
+    // Deduces expression template type - the contraction is recomputed per use
+    Tensor2d A(3, 3);
+    Tensor2d B(3, 3);
+    A.setRandom();
+    B.setRandom();
+    const ContractionDims dims = {Eigen::IndexPair<int>(1, 0)};
+
+    auto C = A.contract(B, dims);  // Deduces Eigen::TensorContractionOp<...> [expect: eigen-auto Eigen::TensorContractionOp]
+    auto D = A;  // Deduces Eigen::Tensor<double, 2>
+
+    Tensor2d E = C;  // Size only known at run time - not reported
+    std::cout << "E(0,0): " << E(0, 0) << ", D(0,0): " << D(0, 0) << std::endl;
+}
+
+void example19b_tensor_device() {
+    // Deduces plain tensor type - large contraction evaluated on a thread pool
+    LargeTensor A;
+    LargeTensor B;
+    A.setRandom();
+    B.setRandom();
+    const ContractionDims dims = {Eigen::IndexPair<int>(1, 0)};
+
+    Eigen::ThreadPool pool(2);
+    Eigen::ThreadPoolDevice device(&pool, 2);
+    LargeTensor C;
+    C.device(device) = A.contract(B, dims);
+
+    LargeTensor D;
+    D = A.contract(B, dims);  // Single-threaded [expect: eigen-tensor-device Eigen::TensorContractionOp]
+
+    std::cout << "C(0,0): " << C(0, 0) << ", D(0,0): " << D(0, 0) << std::endl;
+}
+
+void example19c_small_tensor_contraction() {
+    // Deduces plain tensor type - too small for a thread pool to pay off
+    SmallTensor A;
+    SmallTensor B;
+    A.setRandom();
+    B.setRandom();
+    const ContractionDims dims = {Eigen::IndexPair<int>(1, 0)};
+
+    SmallTensor C;
+    C = A.contract(B, dims);  // Single-threaded, and rightly so
+
+    std::cout << "C(0,0): " << C(0, 0) << std::endl;
+}
+
 // ============================================================================
 // Non-Eigen examples: Same syntax with doubles to verify check doesn't fire
 // ============================================================================
@@ -404,6 +514,24 @@ int main() {
     std::cout << "\n=== Multi-line 4: Parenthesized ===" << std::endl;
     example_multiline4_parenthesized();
 
+    std::cout << "\n=== Example 17: Conditional auto ===" << std::endl;
+    example17_conditional_auto(true);
+
+    std::cout << "\n=== Example 17b: lazy_eval ===" << std::endl;
+    example17b_lazy_eval(true);
+
+    std::cout << "\n=== Example 18: Constrained auto ===" << std::endl;
+    example18_constrained_auto();
+
+    std::cout << "\n=== Example 19: Tensor auto ===" << std::endl;
+    example19_tensor_auto();
+
+    std::cout << "\n=== Example 19b: Tensor on a thread pool ===" << std::endl;
+    example19b_tensor_device();
+
+    std::cout << "\n=== Example 19c: Small tensor contraction ===" << std::endl;
+    example19c_small_tensor_contraction();
+
     std::cout << "\n=== Example 12: Auto with Double ===" << std::endl;
     example12_auto_with_double();
 
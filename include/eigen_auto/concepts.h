@@ -0,0 +1,34 @@
+// C++20 concepts that enforce the eigen-auto rule at compile time.
+//
+// A constrained auto only accepts plain storage types, so capturing an
+// expression template becomes a compile error instead of a silent Product<>:
+//
+//     eigen_auto::EigenPlain auto C = (A * B).eval();   // Eigen::MatrixXd
+//     eigen_auto::EigenPlain auto D = A * B;            // error: Product<...>
+//
+// The checker skips declarations constrained with EigenPlain, since the
+// compiler already guarantees what it would check. EigenExpression is the
+// complement, for generic code that wants to accept (or reject) unevaluated
+// expressions explicitly.
+
+#pragma once
+
+#include <Eigen/Core>
+
+#include <concepts>
+#include <type_traits>
+
+namespace eigen_auto {
+
+// Eigen::Matrix or Eigen::Array, which own their coefficients
+template <typename T>
+concept EigenPlain = std::derived_from<std::remove_cvref_t<T>,
+                                       Eigen::PlainObjectBase<std::remove_cvref_t<T>>>;
+
+// Any other Eigen dense type: expressions, blocks, maps, views
+template <typename T>
+concept EigenExpression =
+    std::derived_from<std::remove_cvref_t<T>, Eigen::DenseBase<std::remove_cvref_t<T>>> &&
+    !EigenPlain<T>;
+
+}  // namespace eigen_auto
@@ -0,0 +1,157 @@
+// Compile-time cost model for fixed-size Eigen expression types.
+//
+// cost_model<Expr> states what evaluating Expr once costs, computed from the
+// expression type alone:
+//
+// - flops: one per coefficient of every coefficient-wise operation, 2 * M * K * N
+//   per M x K times K x N product;
+// - bytes: every plain operand read once, plus the temporary each product is
+//   evaluated into written once (8 bytes per double). The write of the final
+//   destination is not included;
+// - depth: operations on the longest path from the root to a plain operand.
+//
+// It is meant for budgets in hot kernels,
+//
+//     using Update = decltype(A * B + D.transpose());   // A, B, D: Matrix3d
+//     static_assert(eigen_auto::cost_model<Update>::flops <= 64);
+//
+// and is the compile-time counterpart of the estimate the Python tooling
+// derives from canonical type spellings. Only fixed sizes are supported; an
+// expression kind without a specialization below does not compile.
+
+#pragma once
+
+#include <Eigen/Core>
+
+#include <cstddef>
+#include <type_traits>
+
+namespace eigen_auto {
+
+template <typename Expr>
+struct cost_model;
+
+namespace detail {
+
+template <typename Expr>
+using plain_type = std::remove_cv_t<std::remove_reference_t<Expr>>;
+
+template <typename Expr>
+constexpr std::size_t coefficients() {
+    static_assert(Expr::RowsAtCompileTime != Eigen::Dynamic &&
+                      Expr::ColsAtCompileTime != Eigen::Dynamic,
+                  "eigen_auto::cost_model needs fixed-size expressions");
+    return std::size_t(Expr::RowsAtCompileTime) * std::size_t(Expr::ColsAtCompileTime);
+}
+
+template <typename Expr>
+constexpr std::size_t coefficient_bytes() {
+    return coefficients<Expr>() * sizeof(typename Expr::Scalar);
+}
+
+constexpr std::size_t max_depth(std::size_t a, std::size_t b) { return a > b ? a : b; }
+
+// A plain operand: read once, nothing computed
+template <typename Expr>
+struct leaf_cost {
+    static constexpr std::size_t flops = 0;
+    static constexpr std::size_t bytes = coefficient_bytes<Expr>();
+    static constexpr std::size_t depth = 0;
+};
+
+// An operation that forwards to its operand, e.g. a transpose
+template <typename Nested>
+struct view_cost {
+    static constexpr std::size_t flops = cost_model<plain_type<Nested>>::flops;
+    static constexpr std::size_t bytes = cost_model<plain_type<Nested>>::bytes;
+    static constexpr std::size_t depth = cost_model<plain_type<Nested>>::depth + 1;
+};
+
+}  // namespace detail
+
+template <typename Scalar, int Rows, int Cols, int Options, int MaxRows, int MaxCols>
+struct cost_model<Eigen::Matrix<Scalar, Rows, Cols, Options, MaxRows, MaxCols>>
+    : detail::leaf_cost<Eigen::Matrix<Scalar, Rows, Cols, Options, MaxRows, MaxCols>> {};
+
+template <typename Scalar, int Rows, int Cols, int Options, int MaxRows, int MaxCols>
+struct cost_model<Eigen::Array<Scalar, Rows, Cols, Options, MaxRows, MaxCols>>
+    : detail::leaf_cost<Eigen::Array<Scalar, Rows, Cols, Options, MaxRows, MaxCols>> {};
+
+template <typename Plain, int MapOptions, typename Stride>
+struct cost_model<Eigen::Map<Plain, MapOptions, Stride>>
+    : detail::leaf_cost<Eigen::Map<Plain, MapOptions, Stride>> {};
+
+// Constant, Identity, Zero, ...: generated per coefficient, nothing read
+template <typename NullaryOp, typename Plain>
+struct cost_model<Eigen::CwiseNullaryOp<NullaryOp, Plain>> {
+    static constexpr std::size_t flops = 0;
+    static constexpr std::size_t bytes = 0;
+    static constexpr std::size_t depth = 0;
+};
+
+// A block of a plain object reads only the block; a block of an expression
+// costs the whole expression (exact for products, an upper bound otherwise)
+template <typename Nested, int BlockRows, int BlockCols, bool InnerPanel>
+struct cost_model<Eigen::Block<Nested, BlockRows, BlockCols, InnerPanel>>
+    : std::conditional_t<
+          std::is_base_of_v<Eigen::PlainObjectBase<detail::plain_type<Nested>>,
+                            detail::plain_type<Nested>>,
+          detail::leaf_cost<Eigen::Block<Nested, BlockRows, BlockCols, InnerPanel>>,
+          detail::view_cost<Nested>> {};
+
+template <typename Nested>
+struct cost_model<Eigen::Transpose<Nested>> : detail::view_cost<Nested> {};
+
+template <typename Nested>
+struct cost_model<Eigen::ArrayWrapper<Nested>> : detail::view_cost<Nested> {};
+
+template <typename Nested>
+struct cost_model<Eigen::MatrixWrapper<Nested>> : detail::view_cost<Nested> {};
+
+template <typename UnaryOp, typename Nested>
+struct cost_model<Eigen::CwiseUnaryOp<UnaryOp, Nested>> {
+    using Expr = Eigen::CwiseUnaryOp<UnaryOp, Nested>;
+    static constexpr std::size_t flops =
+        cost_model<detail::plain_type<Nested>>::flops + detail::coefficients<Expr>();
+    static constexpr std::size_t bytes = cost_model<detail::plain_type<Nested>>::bytes;
+    static constexpr std::size_t depth = cost_model<detail::plain_type<Nested>>::depth + 1;
+};
+
+template <typename BinaryOp, typename Lhs, typename Rhs>
+struct cost_model<Eigen::CwiseBinaryOp<BinaryOp, Lhs, Rhs>> {
+    using Expr = Eigen::CwiseBinaryOp<BinaryOp, Lhs, Rhs>;
+    using LhsCost = cost_model<detail::plain_type<Lhs>>;
+    using RhsCost = cost_model<detail::plain_type<Rhs>>;
+    static constexpr std::size_t flops =
+        LhsCost::flops + RhsCost::flops + detail::coefficients<Expr>();
+    static constexpr std::size_t bytes = LhsCost::bytes + RhsCost::bytes;
+    static constexpr std::size_t depth = detail::max_depth(LhsCost::depth, RhsCost::depth) + 1;
+};
+
+// Evaluated into a temporary before any coefficient is used
+template <typename Lhs, typename Rhs, int Option>
+struct cost_model<Eigen::Product<Lhs, Rhs, Option>> {
+    using Expr = Eigen::Product<Lhs, Rhs, Option>;
+    using LhsCost = cost_model<detail::plain_type<Lhs>>;
+    using RhsCost = cost_model<detail::plain_type<Rhs>>;
+    static constexpr std::size_t inner = std::size_t(detail::plain_type<Lhs>::ColsAtCompileTime);
+    static constexpr std::size_t flops =
+        LhsCost::flops + RhsCost::flops + 2 * inner * detail::coefficients<Expr>();
+    static constexpr std::size_t bytes =
+        LhsCost::bytes + RhsCost::bytes + detail::coefficient_bytes<Expr>();
+    static constexpr std::size_t depth = detail::max_depth(LhsCost::depth, RhsCost::depth) + 1;
+};
+
+// FLOP count of evaluating Expr once
+template <typename Expr>
+inline constexpr std::size_t expression_flops = cost_model<detail::plain_type<Expr>>::flops;
+
+// Bytes read from operands and written to product temporaries
+template <typename Expr>
+inline constexpr std::size_t expression_bytes = cost_model<detail::plain_type<Expr>>::bytes;
+
+// Nesting depth of the expression tree
+template <typename Expr>
+inline constexpr std::size_t expression_depth = cost_model<detail::plain_type<Expr>>::depth;
+
+}  // namespace eigen_auto
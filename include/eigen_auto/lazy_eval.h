@@ -0,0 +1,62 @@
+// Memoizing lazy evaluation of an Eigen expression.
+//
+// `auto C = A * B;` is lazy but recomputes the product on every coefficient
+// access (example1 in examples.cpp); `.eval()` computes it once but always,
+// even on paths that never read C. lazy_eval holds the expression and
+// evaluates it into its plain type on the first access only:
+//
+//     eigen_auto::lazy_eval C(A * B);      // nothing computed yet
+//     if (rarely_true) {
+//         use(C(0, 0), C->row(1));         // A * B computed once, here
+//     }
+//
+// Like `auto`, the expression refers to its operands: A and B must outlive C
+// and must not change before the first access. Temporaries inside the
+// expression dangle just as in example3, so evaluate those with .eval() first.
+// The cache is filled from a const accessor and is not synchronized; do not
+// share an unevaluated lazy_eval between threads.
+
+#pragma once
+
+#include <Eigen/Core>
+
+#include <optional>
+
+namespace eigen_auto {
+
+template <typename Expr>
+class lazy_eval {
+public:
+    using PlainObject = typename Expr::PlainObject;
+    using Scalar = typename Expr::Scalar;
+
+    explicit lazy_eval(const Expr& expr) : expr_(expr) {}
+
+    // True once the expression has been evaluated
+    bool evaluated() const { return value_.has_value(); }
+
+    // The evaluated result; evaluates the expression on the first call.
+    const PlainObject& get() const {
+        if (!value_) {
+            value_.emplace(expr_);
+        }
+        return *value_;
+    }
+
+    const PlainObject& operator*() const { return get(); }
+    const PlainObject* operator->() const { return &get(); }
+    operator const PlainObject&() const { return get(); }
+
+    Scalar operator()(Eigen::Index row, Eigen::Index col) const { return get()(row, col); }
+    Scalar operator()(Eigen::Index index) const { return get()(index); }
+
+    // Dimensions are known without evaluating
+    Eigen::Index rows() const { return expr_.rows(); }
+    Eigen::Index cols() const { return expr_.cols(); }
+
+private:
+    Expr expr_;
+    mutable std::optional<PlainObject> value_;
+};
+
+}  // namespace eigen_auto
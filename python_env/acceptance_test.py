@@ -0,0 +1,309 @@
+#!/usr/bin/env python3
+"""
+Acceptance test for the checker against annotated example files.
+
+Expected findings are written next to the code they concern:
+
+    auto C = A * B;  // [expect: eigen-auto Eigen::Product]
+
+means the check `eigen-auto` must report a finding on that line whose
+canonical type (without const/reference) starts with `Eigen::Product`; the
+type is optional. Every finding without an expectation, and every expectation
+without a finding, fails the test.
+
+A file may also declare a performance budget anywhere in a comment:
+
+    // [budget: time=20s memory=768MiB]
+
+Parse plus analysis of the file must stay below the wall time, and the peak
+RSS of the checking process below the memory budget. Each file is checked in
+a fresh process so that memory is attributed to that file alone.
+
+With --clang-tidy-plugin, each file is also checked by the clang-tidy engine,
+and its eigen-auto findings must match those of the libclang engine field by
+field (the checks it does not implement are not compared).
+
+Usage:
+    uv run acceptance_test.py ../build
+    uv run acceptance_test.py ../build ../examples.cpp --budget-scale 2
+    uv run acceptance_test.py ../build --clang-tidy-plugin ../build/clang_tidy_plugin/EigenAutoCheckPlugin.so
+"""
+
+import argparse
+import json
+import re
+import resource
+import subprocess
+import sys
+import time
+from pathlib import Path
+
+DEFAULT_FILES = [Path(__file__).resolve().parent.parent / "examples.cpp"]
+
+_EXPECT_RE = re.compile(r"\[expect: (?P<check>[\w-]+)(?: (?P<type>[^\]\s]+))?\]")
+_BUDGET_RE = re.compile(
+    r"\[budget:(?: time=(?P<time>[\d.]+)s)?(?: memory=(?P<memory>[\d.]+)MiB)?\]"
+)
+
+
+def read_annotations(filename: Path) -> tuple:
+    """
+    Read expectations and budget from a source file.
+
+    Returns:
+        Tuple (dict mapping (line, check) -> expected type prefix or None,
+        dict with optional "time_s" and "memory_mib" budgets)
+    """
+    expectations = {}
+    budget = {}
+    with open(filename, "r", encoding="utf-8") as f:
+        for line_number, line in enumerate(f, start=1):
+            for match in _EXPECT_RE.finditer(line):
+                expectations[(line_number, match["check"])] = match["type"]
+            match = _BUDGET_RE.search(line)
+            if match:
+                if match["time"]:
+                    budget["time_s"] = float(match["time"])
+                if match["memory"]:
+                    budget["memory_mib"] = float(match["memory"])
+    return expectations, budget
+
+
+# Fields both engines report for an eigen-auto finding
+PARITY_FIELDS = (
+    "line",
+    "column",
+    "variable",
+    "type",
+    "type_as_written",
+    "auto_kind",
+    "source",
+)
+
+
+def run_worker(
+    filename: str, build_dir: str, plugin: str = None, clang_tidy: str = "clang-tidy"
+) -> int:
+    """
+    Check one file in this process and print issues and costs as JSON.
+
+    Args:
+        filename: Source file to check
+        build_dir: Directory containing compile_commands.json
+        plugin: EigenAutoCheckPlugin to check with clang-tidy, or None for
+            the libclang engine
+        clang_tidy: clang-tidy executable, used with plugin only
+    """
+    start = time.perf_counter()
+    if plugin:
+        from clang_tidy_engine import check_file_clang_tidy
+
+        with open(filename, "r", encoding="utf-8") as f:
+            source_lines = f.readlines()
+        issues = check_file_clang_tidy(
+            filename, build_dir, plugin, source_lines, clang_tidy
+        )
+    else:
+        import eigen_auto_check as checker
+
+        compdb = checker.load_compilation_database(build_dir)
+        issues = checker.check_file(filename, compdb)
+    elapsed = time.perf_counter() - start
+
+    json.dump(
+        {
+            "issues": issues,
+            "elapsed_s": elapsed,
+            # ru_maxrss is in KiB on Linux
+            "peak_rss_mib": resource.getrusage(resource.RUSAGE_SELF).ru_maxrss / 1024,
+        },
+        sys.stdout,
+    )
+    return 0
+
+
+def check_expectations(expectations: dict, issues: list) -> list:
+    """Compare findings against expectations; return failure messages."""
+    failures = []
+    found = set()
+    for issue in issues:
+        key = (issue["line"], issue["check"])
+        found.add(key)
+        if key not in expectations:
+            failures.append(
+                f"line {issue['line']}: unexpected {issue['check']} finding "
+                f"for '{issue.get('variable', '?')}' ({issue.get('type', '?')})"
+            )
+            continue
+        expected_type = expectations[key]
+        actual_type = issue.get("type", "").removeprefix("const ")
+        if expected_type and not actual_type.startswith(expected_type):
+            failures.append(
+                f"line {issue['line']}: expected type {expected_type}..., "
+                f"got {actual_type}"
+            )
+
+    for line, check in sorted(expectations):
+        if (line, check) not in found:
+            failures.append(f"line {line}: missing {check} finding")
+
+    return failures
+
+
+def check_parity(libclang_issues: list, clang_tidy_issues: list, checks) -> list:
+    """
+    Compare the findings of both engines on the checks clang-tidy implements.
+
+    Returns:
+        Failure messages, one per finding only one engine reports or whose
+        fields differ
+    """
+    def by_location(issues):
+        return {
+            (issue["line"], issue["column"]): issue
+            for issue in issues
+            if issue["check"] in checks
+        }
+
+    expected = by_location(libclang_issues)
+    actual = by_location(clang_tidy_issues)
+    failures = []
+    for location in sorted(expected.keys() | actual.keys()):
+        line = location[0]
+        if location not in actual:
+            failures.append(
+                f"line {line}: clang-tidy misses the finding for "
+                f"'{expected[location]['variable']}'"
+            )
+        elif location not in expected:
+            failures.append(
+                f"line {line}: clang-tidy reports an extra finding for "
+                f"'{actual[location]['variable']}'"
+            )
+        else:
+            for field in PARITY_FIELDS:
+                if expected[location][field] != actual[location][field]:
+                    failures.append(
+                        f"line {line}: {field} differs: libclang "
+                        f"{expected[location][field]!r}, clang-tidy "
+                        f"{actual[location][field]!r}"
+                    )
+    return failures
+
+
+def run_file(filename: Path, build_dir: str, extra_args: list = ()) -> tuple:
+    """
+    Check a file in a fresh worker process.
+
+    Returns:
+        Tuple (result dict, or None if the worker failed; its stderr)
+    """
+    completed = subprocess.run(
+        [sys.executable, __file__, "--worker", build_dir, str(filename), *extra_args],
+        capture_output=True,
+        text=True,
+    )
+    if completed.returncode != 0:
+        return None, completed.stderr
+    return json.loads(completed.stdout), completed.stderr
+
+
+def check_budget(budget: dict, result: dict, scale: float) -> list:
+    """Compare measured costs against the file's budget."""
+    failures = []
+    if "time_s" in budget and result["elapsed_s"] > budget["time_s"] * scale:
+        failures.append(
+            f"parse+analysis took {result['elapsed_s']:.2f}s, "
+            f"budget {budget['time_s'] * scale:.2f}s"
+        )
+    if "memory_mib" in budget and result["peak_rss_mib"] > budget["memory_mib"] * scale:
+        failures.append(
+            f"peak RSS {result['peak_rss_mib']:.1f} MiB, "
+            f"budget {budget['memory_mib'] * scale:.1f} MiB"
+        )
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Check annotated example files for exact findings and budgets"
+    )
+    parser.add_argument("build_dir", help="Build directory containing compile_commands.json")
+    parser.add_argument(
+        "files", nargs="*", help="Annotated source files (default: ../examples.cpp)"
+    )
+    parser.add_argument(
+        "--budget-scale",
+        type=float,
+        default=1.0,
+        help="Multiply all budgets, e.g. 2 on slow CI machines (default: 1)",
+    )
+    parser.add_argument(
+        "--clang-tidy-plugin",
+        metavar="PLUGIN",
+        help="Also check with the clang-tidy engine and compare its findings",
+    )
+    parser.add_argument(
+        "--clang-tidy",
+        default="clang-tidy",
+        metavar="EXE",
+        help="clang-tidy executable for --clang-tidy-plugin (default: clang-tidy)",
+    )
+    parser.add_argument("--worker", action="store_true", help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.worker:
+        return run_worker(
+            args.files[0], args.build_dir, args.clang_tidy_plugin, args.clang_tidy
+        )
+
+    files = [Path(f).resolve() for f in args.files] or DEFAULT_FILES
+    all_passed = True
+    for filename in files:
+        expectations, budget = read_annotations(filename)
+        result, stderr = run_file(filename, args.build_dir)
+        if result is None:
+            print(f"✗ {filename}: checker failed\n{stderr}")
+            all_passed = False
+            continue
+
+        failures = check_expectations(expectations, result["issues"])
+        failures += check_budget(budget, result, args.budget_scale)
+
+        if args.clang_tidy_plugin:
+            from clang_tidy_engine import CHECKS
+
+            tidy_result, stderr = run_file(
+                filename,
+                args.build_dir,
+                [
+                    "--clang-tidy-plugin",
+                    args.clang_tidy_plugin,
+                    "--clang-tidy",
+                    args.clang_tidy,
+                ],
+            )
+            if tidy_result is None:
+                failures.append(f"clang-tidy engine failed\n{stderr}")
+            else:
+                failures += check_parity(
+                    result["issues"], tidy_result["issues"], CHECKS
+                )
+
+        summary = (
+            f"{len(result['issues'])} finding(s), {result['elapsed_s']:.2f}s, "
+            f"{result['peak_rss_mib']:.1f} MiB"
+        )
+        if failures:
+            all_passed = False
+            print(f"✗ {filename}: {summary}")
+            for failure in failures:
+                print(f"  {failure}")
+        else:
+            print(f"✓ {filename}: {summary}")
+
+    return 0 if all_passed else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+"""
+CPU and NUMA placement of analysis workers.
+
+On multi-socket machines a worker that migrates to another socket keeps
+reading its translation unit (often hundreds of MB of AST) from the memory
+of the node it started on. Pinning keeps each worker next to its memory:
+
+- "node": a worker may run on any CPU of one NUMA node; workers are spread
+  round-robin over the nodes;
+- "cpu": additionally, each worker gets a CPU of its own within its node;
+- "none": the scheduler decides (the default).
+
+Nodes are read from /sys/devices/system/node and restricted to the CPUs this
+process may run on; without NUMA information all allowed CPUs form one node.
+Linux sched_setaffinity() applies to the calling thread, so the same
+placement works for analysis threads and for worker processes. A worker
+should pin itself before allocating anything large (its libclang Index,
+caches), so that first-touch allocation puts that memory on its node.
+
+Usage:
+    uv run affinity.py
+    uv run eigen_auto_check.py --all ../build --jobs 16 --pin=node
+"""
+
+import os
+import threading
+from pathlib import Path
+
+PIN_MODES = ("none", "node", "cpu")
+
+NODE_ROOT = Path("/sys/devices/system/node")
+
+
+class Placement:
+    """Where one worker runs: a NUMA node and the CPUs it may use there."""
+
+    # A plain class rather than a dataclass: the checker imports this module
+    # on every run, and dataclasses (with inspect) would dominate its cold start
+    __slots__ = ("worker", "node", "cpus")
+
+    def __init__(self, worker: int, node: int, cpus: frozenset):
+        self.worker = worker
+        self.node = node
+        self.cpus = cpus
+
+
+def parse_cpulist(text: str) -> list:
+    """
+    Parse a kernel CPU list such as "0-3,8-11,16".
+
+    Returns:
+        Sorted list of CPU numbers
+    """
+    cpus = set()
+    for part in text.strip().split(","):
+        if not part:
+            continue
+        first, _, last = part.partition("-")
+        cpus.update(range(int(first), int(last or first) + 1))
+    return sorted(cpus)
+
+
+def allowed_cpus() -> set:
+    """CPUs this process may run on."""
+    if hasattr(os, "sched_getaffinity"):
+        return set(os.sched_getaffinity(0))
+    return set(range(os.cpu_count() or 1))
+
+
+def numa_nodes(root: Path = NODE_ROOT) -> dict:
+    """
+    Map each NUMA node to the allowed CPUs it contains.
+
+    Nodes without allowed CPUs (memory-only nodes, or excluded by an outer
+    cpuset) are left out.
+
+    Returns:
+        Dict node id -> sorted list of CPUs; a single node 0 if the machine
+        exposes no NUMA topology
+    """
+    allowed = allowed_cpus()
+    nodes = {}
+    for cpulist in sorted(root.glob("node[0-9]*/cpulist")):
+        node = int(cpulist.parent.name.removeprefix("node"))
+        try:
+            cpus = [cpu for cpu in parse_cpulist(cpulist.read_text()) if cpu in allowed]
+        except (OSError, ValueError):
+            continue
+        if cpus:
+            nodes[node] = cpus
+    if not nodes:
+        nodes = {0: sorted(allowed)}
+    return nodes
+
+
+def plan_placements(jobs: int, mode: str, nodes: dict = None) -> list:
+    """
+    Assign workers to nodes and CPUs.
+
+    Workers alternate between nodes, so that any number of workers loads the
+    nodes evenly. In "cpu" mode worker i takes the (i // number of nodes)-th
+    CPU of its node; with more workers than CPUs, CPUs are shared.
+
+    Args:
+        jobs: Number of workers
+        mode: One of PIN_MODES
+        nodes: Result of numa_nodes(), read from the machine if None
+
+    Returns:
+        List of Placement, one per worker; empty for mode "none"
+    """
+    if mode not in PIN_MODES:
+        raise ValueError(f"unknown pin mode '{mode}', expected one of {PIN_MODES}")
+    if mode == "none":
+        return []
+    if nodes is None:
+        nodes = numa_nodes()
+    node_ids = sorted(nodes)
+    placements = []
+    for worker in range(jobs):
+        node = node_ids[worker % len(node_ids)]
+        cpus = nodes[node]
+        if mode == "cpu":
+            cpus = [cpus[(worker // len(node_ids)) % len(cpus)]]
+        placements.append(Placement(worker, node, frozenset(cpus)))
+    return placements
+
+
+def pin_current(placement: Placement) -> bool:
+    """
+    Restrict the calling thread (or process) to a placement's CPUs.
+
+    Returns:
+        False if the platform has no affinity support or the kernel refused
+    """
+    if not hasattr(os, "sched_setaffinity"):
+        return False
+    try:
+        os.sched_setaffinity(0, placement.cpus)
+    except OSError:
+        return False
+    return True
+
+
+class PlacementPool:
+    """
+    Hands out placements to workers as they start.
+
+    Workers call claim() once; the first worker gets placement 0 and so on,
+    regardless of the order the pool created them in. Beyond the planned
+    workers claim() returns None and the worker stays unpinned.
+    """
+
+    def __init__(self, placements: list):
+        self._placements = list(placements)
+        self._next = 0
+        self._lock = threading.Lock()
+
+    def claim(self):
+        with self._lock:
+            if self._next >= len(self._placements):
+                return None
+            placement = self._placements[self._next]
+            self._next += 1
+            return placement
+
+
+def format_placement(placement: Placement) -> str:
+    """Short description of a placement, e.g. "node 1, CPUs 8-15"."""
+    cpus = sorted(placement.cpus)
+    ranges = []
+    start = previous = cpus[0]
+    for cpu in cpus[1:] + [None]:
+        if cpu is not None and cpu == previous + 1:
+            previous = cpu
+            continue
+        ranges.append(str(start) if start == previous else f"{start}-{previous}")
+        if cpu is not None:
+            start = previous = cpu
+    label = "CPU" if len(cpus) == 1 else "CPUs"
+    return f"node {placement.node}, {label} {','.join(ranges)}"
+
+
+def main():
+    import argparse
+
+    parser = argparse.ArgumentParser(description="Show the worker placement plan")
+    parser.add_argument("--jobs", "-j", type=int, default=os.cpu_count() or 1)
+    parser.add_argument("--pin", choices=PIN_MODES, default="cpu")
+    args = parser.parse_args()
+
+    nodes = numa_nodes()
+    for node, cpus in nodes.items():
+        print(f"node {node}: {len(cpus)} CPU(s)")
+    for placement in plan_placements(args.jobs, args.pin, nodes):
+        print(f"worker {placement.worker}: {format_placement(placement)}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,336 @@
+#!/usr/bin/env python3
+"""
+Size-bounded analysis cache shared between workers and machines.
+
+Entries are files under <root>/objects/<2 hex>/<rest of key>. The cache is
+safe to share on a network filesystem between many concurrent writers:
+
+- writers create the entry in <root>/tmp under a unique name and rename it
+  into place, so readers see either nothing or a complete entry;
+- readers take no locks; a hit refreshes the entry's mtime, which serves as
+  its last-use time for LRU eviction;
+- prune() deletes least recently used entries until the cache fits its size
+  cap, ignoring entries that another pruner removed first.
+
+Every run records its hit/miss counts as a small file under <root>/stats so
+that `eigen_auto_check.py cache stats` can report the cumulative hit rate.
+Once more than STATS_COMPACT_THRESHOLD files accumulate, and on every prune,
+they are folded into a single totals file, so the directory stays small no
+matter how many runs share the cache.
+
+Usage:
+    uv run eigen_auto_check.py cache stats --cache-dir ~/.cache/eigen-auto-check
+    uv run eigen_auto_check.py cache prune --cache-dir ~/.cache/eigen-auto-check --max-size 2G
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import sys
+import time
+from pathlib import Path
+
+# Runs use the cache only when this variable or --cache-dir is set
+CACHE_DIR_ENV = "EIGEN_AUTO_CHECK_CACHE_DIR"
+
+DEFAULT_CACHE_DIR = os.environ.get(
+    CACHE_DIR_ENV, str(Path.home() / ".cache" / "eigen-auto-check")
+)
+
+DEFAULT_MAX_SIZE = "1G"
+
+# Run records in <root>/stats beyond which record_run() folds them together
+STATS_COMPACT_THRESHOLD = 64
+
+_SIZE_UNITS = {"": 1, "K": 1024, "M": 1024**2, "G": 1024**3, "T": 1024**4}
+
+
+def parse_size(text: str) -> int:
+    """Parse a size such as "512M" or "2G" into bytes."""
+    text = text.strip().upper().removesuffix("B")
+    unit = text[-1] if text and text[-1] in _SIZE_UNITS else ""
+    number = text[: len(text) - len(unit)]
+    try:
+        return int(float(number) * _SIZE_UNITS[unit])
+    except ValueError:
+        raise ValueError(f"Invalid size: {text!r}") from None
+
+
+def format_size(size: int) -> str:
+    """Format a byte count for humans."""
+    value = float(size)
+    for unit in ("B", "KiB", "MiB"):
+        if value < 1024:
+            return f"{size} B" if unit == "B" else f"{value:.1f} {unit}"
+        value /= 1024
+    return f"{value:.1f} GiB"
+
+
+def _unique_name() -> str:
+    """A file name no other writer on any host can pick concurrently."""
+    # Imported lazily: socket and uuid add to the checker's cold start
+    import socket
+    import uuid
+
+    return f"{socket.gethostname()}.{os.getpid()}.{uuid.uuid4().hex}"
+
+
+def make_key(*parts) -> str:
+    """Hash the given strings/bytes into a cache key."""
+    digest = hashlib.blake2b(digest_size=20)
+    for part in parts:
+        if isinstance(part, str):
+            part = part.encode()
+        digest.update(len(part).to_bytes(8, "little"))
+        digest.update(part)
+    return digest.hexdigest()
+
+
+class AnalysisCache:
+    """
+    A directory of cache entries with LRU eviction and hit statistics.
+
+    get() and put() do no bookkeeping so that they can be called from any
+    thread or worker process; the owner of a run sums the outcomes into
+    `hits`, `misses` and `writes` before calling record_run().
+    """
+
+    def __init__(self, root: str, max_size: int = None):
+        self.root = Path(root)
+        self.max_size = max_size
+        self.hits = 0
+        self.misses = 0
+        self.writes = 0
+        for sub in ("objects", "tmp", "stats"):
+            (self.root / sub).mkdir(parents=True, exist_ok=True)
+
+    def _path(self, key: str) -> Path:
+        return self.root / "objects" / key[:2] / key[2:]
+
+    def get(self, key: str):
+        """
+        Read an entry without locking.
+
+        Returns:
+            The entry's bytes, or None on a miss
+        """
+        path = self._path(key)
+        try:
+            with open(path, "rb") as f:
+                data = f.read()
+        except FileNotFoundError:
+            return None
+        try:
+            # Mark as recently used for LRU eviction
+            os.utime(path)
+        except OSError:
+            pass
+        return data
+
+    def put(self, key: str, data: bytes) -> None:
+        """Atomically publish an entry."""
+        path = self._path(key)
+        path.parent.mkdir(exist_ok=True)
+        tmp_path = self.root / "tmp" / _unique_name()
+        with open(tmp_path, "wb") as f:
+            f.write(data)
+        os.replace(tmp_path, path)
+
+    def get_json(self, key: str):
+        data = self.get(key)
+        return None if data is None else json.loads(data)
+
+    def put_json(self, key: str, value) -> None:
+        self.put(key, json.dumps(value).encode())
+
+    def entries(self) -> list:
+        """Return (mtime, size, path) of every entry."""
+        result = []
+        for directory in (self.root / "objects").iterdir():
+            try:
+                names = list(directory.iterdir())
+            except (FileNotFoundError, NotADirectoryError):
+                continue
+            for path in names:
+                try:
+                    stat = path.stat()
+                except FileNotFoundError:
+                    continue
+                result.append((stat.st_mtime, stat.st_size, path))
+        return result
+
+    def prune(self, max_size: int = None) -> tuple:
+        """
+        Evict least recently used entries until the cache fits max_size.
+
+        Also removes temporary files abandoned by crashed writers.
+
+        Returns:
+            Tuple (entries removed, bytes freed)
+        """
+        max_size = self.max_size if max_size is None else max_size
+        removed = freed = 0
+
+        stale = time.time() - 3600
+        for path in (self.root / "tmp").iterdir():
+            try:
+                if path.stat().st_mtime < stale:
+                    path.unlink()
+            except FileNotFoundError:
+                pass
+
+        self.compact_stats()
+
+        if max_size is None:
+            return removed, freed
+
+        entries = self.entries()
+        total = sum(size for _, size, _ in entries)
+        for _, size, path in sorted(entries, key=lambda entry: entry[0]):
+            if total <= max_size:
+                break
+            try:
+                path.unlink()
+                removed += 1
+                freed += size
+            except FileNotFoundError:
+                pass
+            total -= size
+        return removed, freed
+
+    def record_run(self) -> None:
+        """Persist this run's hit/miss counts for `cache stats`."""
+        if not (self.hits or self.misses or self.writes):
+            return
+        stats = {
+            "time": time.time(),
+            "hits": self.hits,
+            "misses": self.misses,
+            "writes": self.writes,
+        }
+        self._write_stats(stats)
+        try:
+            count = sum(1 for _ in os.scandir(self.root / "stats"))
+        except FileNotFoundError:
+            return
+        if count > STATS_COMPACT_THRESHOLD:
+            self.compact_stats()
+
+    def _write_stats(self, stats: dict) -> None:
+        """Atomically publish a stats record under a unique name."""
+        name = f"{_unique_name()}.json"
+        tmp_path = self.root / "tmp" / name
+        with open(tmp_path, "w", encoding="utf-8") as f:
+            json.dump(stats, f)
+        os.replace(tmp_path, self.root / "stats" / name)
+
+    def compact_stats(self) -> None:
+        """
+        Fold all stats records into one totals record.
+
+        Each record is first claimed by renaming it into <root>/tmp, which
+        only one of several concurrent compactions can do, so no run is
+        counted twice. The totals are published before the claimed records
+        are deleted; a compaction that crashes in between loses its records
+        to the stale-file cleanup of prune() rather than double counting.
+        """
+        totals = {"time": time.time(), "runs": 0, "hits": 0, "misses": 0, "writes": 0}
+        claimed = []
+        for path in (self.root / "stats").glob("*.json"):
+            tmp_path = self.root / "tmp" / f"{_unique_name()}.stats"
+            try:
+                os.replace(path, tmp_path)
+            except FileNotFoundError:
+                continue
+            claimed.append(tmp_path)
+            stats = self._read_stats(tmp_path)
+            if stats is None:
+                continue
+            totals["runs"] += stats.get("runs", 1)
+            for key in ("hits", "misses", "writes"):
+                totals[key] += stats.get(key, 0)
+        if claimed:
+            self._write_stats(totals)
+        for tmp_path in claimed:
+            tmp_path.unlink()
+
+    @staticmethod
+    def _read_stats(path: Path):
+        try:
+            with open(path, "r", encoding="utf-8") as f:
+                return json.load(f)
+        except (FileNotFoundError, json.JSONDecodeError):
+            return None
+
+    def cumulative_stats(self) -> dict:
+        """Sum the recorded statistics of all runs."""
+        totals = {"runs": 0, "hits": 0, "misses": 0, "writes": 0}
+        for path in (self.root / "stats").glob("*.json"):
+            stats = self._read_stats(path)
+            if stats is None:
+                continue
+            # Totals records written by compact_stats() cover several runs
+            totals["runs"] += stats.get("runs", 1)
+            for key in ("hits", "misses", "writes"):
+                totals[key] += stats.get(key, 0)
+        return totals
+
+    def summary(self) -> str:
+        """One-line hit rate summary of this run."""
+        lookups = self.hits + self.misses
+        rate = 100.0 * self.hits / lookups if lookups else 0.0
+        return f"Cache: {self.hits} hit(s), {self.misses} miss(es) ({rate:.0f}% hit rate)"
+
+
+def main(argv: list) -> int:
+    """Entry point of the `cache` subcommand."""
+    parser = argparse.ArgumentParser(
+        prog="eigen_auto_check.py cache",
+        description="Inspect or prune the shared analysis cache",
+    )
+    parser.add_argument("action", choices=("stats", "prune"))
+    parser.add_argument(
+        "--cache-dir",
+        default=DEFAULT_CACHE_DIR,
+        help=f"Cache directory (default: {DEFAULT_CACHE_DIR})",
+    )
+    parser.add_argument(
+        "--max-size",
+        default=DEFAULT_MAX_SIZE,
+        help=f"Size cap for prune, e.g. 500M or 2G (default: {DEFAULT_MAX_SIZE})",
+    )
+    args = parser.parse_args(argv)
+
+    try:
+        max_size = parse_size(args.max_size)
+    except ValueError as e:
+        parser.error(str(e))
+
+    cache = AnalysisCache(args.cache_dir, max_size)
+
+    if args.action == "prune":
+        removed, freed = cache.prune()
+        print(f"Removed {removed} entries, freed {format_size(freed)}")
+        return 0
+
+    entries = cache.entries()
+    totals = cache.cumulative_stats()
+    lookups = totals["hits"] + totals["misses"]
+    rate = 100.0 * totals["hits"] / lookups if lookups else 0.0
+    print(f"Cache directory: {cache.root}")
+    print(f"Entries:         {len(entries)}")
+    print(
+        f"Size:            {format_size(sum(size for _, size, _ in entries))}"
+        f" (cap {format_size(max_size)})"
+    )
+    print(f"Runs recorded:   {totals['runs']}")
+    print(
+        f"Hits / misses:   {totals['hits']} / {totals['misses']} ({rate:.0f}% hit rate)"
+    )
+    print(f"Writes:          {totals['writes']}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""
+Compare the thread and process backends of `eigen_auto_check.py --all`.
+
+Each backend runs in a fresh interpreter on the same synthetic project so
+that neither benefits from warm caches of the other. Reported per backend:
+wall time, the summed CPU time, the peak RSS of the largest process (from
+wait4() on that run's checker alone) and the peak of the RSS summed over the
+checker and all its worker processes (sampled from /proc).
+
+Usage:
+    uv run synthetic_project.py /tmp/synth --tus 1000
+    uv run bench_backends.py /tmp/synth/build --jobs 16
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import threading
+import time
+from pathlib import Path
+
+CHECKER = Path(__file__).resolve().parent / "eigen_auto_check.py"
+
+# Interval of the /proc RSS sampler in seconds
+RSS_SAMPLE_INTERVAL = 0.05
+
+_PAGE_SIZE = os.sysconf("SC_PAGE_SIZE") if hasattr(os, "sysconf") else 4096
+
+
+def process_tree(root: int) -> list:
+    """List a process and all its descendants, read from /proc."""
+    children = {}
+    for entry in os.scandir("/proc"):
+        if not entry.name.isdigit():
+            continue
+        try:
+            with open(f"/proc/{entry.name}/stat", "rb") as f:
+                stat = f.read()
+        except OSError:
+            continue
+        # The command name may contain spaces; the fields after it do not
+        ppid = int(stat[stat.rindex(b")") + 2 :].split()[1])
+        children.setdefault(ppid, []).append(int(entry.name))
+    tree = [root]
+    for pid in tree:
+        tree.extend(children.get(pid, []))
+    return tree
+
+
+def tree_rss(root: int) -> int:
+    """Resident bytes of a process and its descendants right now."""
+    total = 0
+    for pid in process_tree(root):
+        try:
+            with open(f"/proc/{pid}/statm", "rb") as f:
+                total += int(f.read().split()[1]) * _PAGE_SIZE
+        except (OSError, ValueError, IndexError):
+            continue
+    return total
+
+
+class TreeRssSampler(threading.Thread):
+    """Samples the summed RSS of a process tree until stopped."""
+
+    def __init__(self, root: int):
+        super().__init__(daemon=True)
+        self.root = root
+        self.peak = 0
+        self._stopped = threading.Event()
+
+    def run(self):
+        while not self._stopped.is_set():
+            self.peak = max(self.peak, tree_rss(self.root))
+            self._stopped.wait(RSS_SAMPLE_INTERVAL)
+
+    def stop(self) -> int:
+        """Stop sampling; returns the peak in bytes."""
+        self._stopped.set()
+        self.join()
+        return self.peak
+
+
+def run_backend(build_dir: str, backend: str, jobs: int, pin: str = "none") -> dict:
+    """Run the checker once with the given backend and placement and measure it."""
+    start = time.perf_counter()
+    process = subprocess.Popen(
+        [
+            sys.executable,
+            str(CHECKER),
+            "--all",
+            build_dir,
+            "--backend",
+            backend,
+            "--jobs",
+            str(jobs),
+            "--pin",
+            pin,
+        ],
+        stdout=subprocess.DEVNULL,
+        stderr=subprocess.PIPE,
+        text=True,
+    )
+    sampler = TreeRssSampler(process.pid)
+    sampler.start()
+    # Drain stderr so that the checker cannot block on a full pipe; wait4()
+    # then reports the rusage of this run's checker and the workers it reaped
+    # instead of the totals of every child this benchmark ever had
+    stderr = process.stderr.read()
+    peak_total = sampler.stop()
+    _, status, rusage = os.wait4(process.pid, 0)
+    wall = time.perf_counter() - start
+    process.returncode = os.waitstatus_to_exitcode(status)
+
+    if process.returncode not in (0, 1):
+        raise RuntimeError(f"{backend} backend failed:\n{stderr}")
+
+    return {
+        "backend": backend,
+        "pin": pin,
+        "wall_s": wall,
+        "cpu_s": rusage.ru_utime + rusage.ru_stime,
+        # ru_maxrss is in KiB on Linux: the largest single process of the run
+        "peak_rss_mib": rusage.ru_maxrss / 1024,
+        # Sum over the checker and its workers, at the sampled peak
+        "peak_total_rss_mib": peak_total / (1024 * 1024),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Benchmark the thread and process backends of --all"
+    )
+    parser.add_argument("build_dir", help="Directory containing compile_commands.json")
+    parser.add_argument(
+        "--jobs", "-j", type=int, default=os.cpu_count() or 1, help="Workers"
+    )
+    parser.add_argument(
+        "--repetitions", type=int, default=1, help="Runs per backend"
+    )
+    args = parser.parse_args()
+
+    print(
+        f"{'backend':<12} {'wall':>9} {'cpu':>9} {'peak RSS':>11} "
+        f"{'total RSS':>11}"
+    )
+    for backend in ("threads", "processes"):
+        for _ in range(args.repetitions):
+            r = run_backend(args.build_dir, backend, args.jobs)
+            print(
+                f"{r['backend']:<12} {r['wall_s']:8.2f}s {r['cpu_s']:8.2f}s "
+                f"{r['peak_rss_mib']:8.1f} MiB {r['peak_total_rss_mib']:8.1f} MiB"
+            )
+
+
+if __name__ == "__main__":
+    main()
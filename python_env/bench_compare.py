@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""
+Compare two examples_benchmark JSON results for significant slowdowns.
+
+Each benchmark's repetitions in the candidate run are tested against the
+baseline with a one-sided Mann-Whitney U test (candidate slower). The test
+uses ranks only, so a single noisy repetition cannot flip the verdict the way
+it flips a "median 10% slower" threshold. With many benchmarks the per-test
+threshold is Bonferroni-corrected by default, so that the chance of any false
+alarm in a nightly run stays at --alpha.
+
+The exit status is 1 if any benchmark is significantly slower (and slower by
+at least --min-change), 0 otherwise.
+
+Usage:
+    ../build/benchmark/examples_benchmark --repetitions 15 --json base.json
+    ../build/benchmark/examples_benchmark --repetitions 15 --json new.json
+    uv run bench_compare.py base.json new.json --alpha 0.01
+"""
+
+import argparse
+import json
+import math
+import statistics
+import sys
+
+# Largest n1 * n2 for which the exact U distribution is enumerated
+EXACT_LIMIT = 2500
+
+
+def rank_with_ties(values: list) -> tuple:
+    """
+    Rank values from 1, giving tied values their average rank.
+
+    Returns:
+        Tuple (ranks in input order, list of tie group sizes)
+    """
+    order = sorted(range(len(values)), key=lambda i: values[i])
+    ranks = [0.0] * len(values)
+    ties = []
+    start = 0
+    while start < len(order):
+        end = start
+        while end + 1 < len(order) and values[order[end + 1]] == values[order[start]]:
+            end += 1
+        for position in range(start, end + 1):
+            ranks[order[position]] = (start + end) / 2 + 1
+        if end > start:
+            ties.append(end - start + 1)
+        start = end + 1
+    return ranks, ties
+
+
+def _exact_upper_tail(u: float, n1: int, n2: int) -> float:
+    """P(U >= u) under the null hypothesis, without ties."""
+    # counts[k] = number of rank arrangements with U = k, built up one
+    # observation at a time (the classic recurrence, as a 2D table over n2)
+    max_u = n1 * n2
+    table = [[[1] + [0] * max_u for _ in range(n2 + 1)]]
+    for i in range(1, n1 + 1):
+        row = [[1] + [0] * max_u]
+        for j in range(1, n2 + 1):
+            counts = [0] * (max_u + 1)
+            previous_i = table[i - 1][j]
+            previous_j = row[j - 1]
+            for k in range(max_u + 1):
+                counts[k] = previous_j[k] + (previous_i[k - j] if k >= j else 0)
+            row.append(counts)
+        table.append(row)
+    counts = table[n1][n2]
+    total = math.comb(n1 + n2, n1)
+    return sum(counts[math.ceil(u) :]) / total
+
+
+def mann_whitney_greater(baseline: list, candidate: list) -> float:
+    """
+    One-sided Mann-Whitney U test that candidate values tend to be larger.
+
+    Uses the exact null distribution for small samples without ties and the
+    normal approximation with tie and continuity correction otherwise.
+
+    Returns:
+        p-value
+    """
+    n1, n2 = len(candidate), len(baseline)
+    ranks, ties = rank_with_ties(list(candidate) + list(baseline))
+    u = sum(ranks[:n1]) - n1 * (n1 + 1) / 2
+
+    if not ties and n1 * n2 <= EXACT_LIMIT:
+        return _exact_upper_tail(u, n1, n2)
+
+    n = n1 + n2
+    tie_term = sum(t**3 - t for t in ties) / (n * (n - 1))
+    sigma = math.sqrt(n1 * n2 / 12 * ((n + 1) - tie_term))
+    if sigma == 0:
+        return 1.0
+    z = (u - n1 * n2 / 2 - 0.5) / sigma
+    return 0.5 * math.erfc(z / math.sqrt(2))
+
+
+def load_results(path: str) -> dict:
+    """Map benchmark name to its list of seconds per call."""
+    with open(path, "r", encoding="utf-8") as f:
+        data = json.load(f)
+    return {b["name"]: b["seconds_per_call"] for b in data["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Detect statistically significant benchmark slowdowns"
+    )
+    parser.add_argument("baseline", help="JSON written by examples_benchmark --json")
+    parser.add_argument("candidate", help="JSON of the run to check")
+    parser.add_argument(
+        "--alpha",
+        type=float,
+        default=0.01,
+        help="Family-wise significance level (default: 0.01)",
+    )
+    parser.add_argument(
+        "--correction",
+        choices=("bonferroni", "none"),
+        default="bonferroni",
+        help="Multiple-comparison correction across benchmarks (default: bonferroni)",
+    )
+    parser.add_argument(
+        "--min-change",
+        type=float,
+        default=0.0,
+        help="Ignore significant slowdowns of the median below this fraction, "
+        "e.g. 0.02 for 2%% (default: 0)",
+    )
+    args = parser.parse_args()
+
+    baseline = load_results(args.baseline)
+    candidate = load_results(args.candidate)
+    common = [name for name in baseline if name in candidate]
+    for name in sorted(set(baseline) ^ set(candidate)):
+        side = "baseline" if name in baseline else "candidate"
+        print(f"Note: {name} only in {side}, not compared", file=sys.stderr)
+    if not common:
+        print("Error: no benchmarks in common", file=sys.stderr)
+        return 2
+
+    alpha = args.alpha / len(common) if args.correction == "bonferroni" else args.alpha
+
+    slower = []
+    print(
+        f"{'benchmark':<32} {'baseline':>12} {'candidate':>12} {'change':>8} "
+        f"{'p(slower)':>10} {'p(faster)':>10}  verdict"
+    )
+    for name in common:
+        base, new = baseline[name], candidate[name]
+        base_median = statistics.median(base)
+        new_median = statistics.median(new)
+        change = new_median / base_median - 1 if base_median > 0 else 0.0
+        p_slower = mann_whitney_greater(base, new)
+        p_faster = mann_whitney_greater(new, base)
+
+        verdict = "same"
+        if p_slower < alpha and change >= args.min_change:
+            verdict = "SLOWER"
+            slower.append(name)
+        elif p_faster < alpha:
+            verdict = "faster"
+        # The smallest p-value these sample sizes can produce
+        if math.comb(len(base) + len(new), len(new)) * alpha < 1:
+            verdict += " (too few repetitions)"
+
+        print(
+            f"{name:<32} {base_median * 1e9:10.1f}ns {new_median * 1e9:10.1f}ns "
+            f"{change * 100:+7.1f}% {p_slower:10.2g} {p_faster:10.2g}  {verdict}"
+        )
+
+    print(
+        f"\n{len(slower)} of {len(common)} benchmark(s) significantly slower "
+        f"(alpha {args.alpha:g}, per test {alpha:.2g})"
+    )
+    return 1 if slower else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,306 @@
+#!/usr/bin/env python3
+"""
+Microbenchmarks for the hot functions of eigen_auto_check.py.
+
+Each benchmark times one function in isolation on prepared inputs, so that a
+regression in, say, the allowlist check is visible separately from parse
+time:
+
+    analyze_var_decl       every VAR_DECL of a pre-parsed TU
+    is_in_eigen_namespace  types declared in deeply nested namespaces
+    is_allowed_auto_type   expression types with kilobyte-long spellings
+    get_compile_args       lookups in a 100k-entry compilation database
+    get_source_range       ranges from a large file
+    function_fingerprint   every function definition of a pre-parsed TU
+    run_checks_cached      re-analysis of an unchanged TU with a warm
+                           FunctionCache (watch/daemon mode)
+
+Usage:
+    uv run bench_hot_functions.py ../examples.cpp ../build
+    uv run bench_hot_functions.py ../examples.cpp ../build --only get_compile_args --json out.json
+"""
+
+import argparse
+import json
+import statistics
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+import clang.cindex
+
+import check_registry
+import eigen_auto_check as checker
+
+# Nesting depth of the namespace used for is_in_eigen_namespace
+NAMESPACE_DEPTH = 32
+
+# Number of terms in the expression used for is_allowed_auto_type
+EXPRESSION_TERMS = 24
+
+# Size of the synthetic compilation database for get_compile_args
+COMPDB_ENTRIES = 100_000
+
+# Size of the synthetic file for get_source_range
+LARGE_FILE_LINES = 200_000
+
+
+def measure(function, repeat: int, number: int) -> dict:
+    """
+    Time `function` `number` times per round for `repeat` rounds.
+
+    Returns:
+        Dict with the best and median time per call in microseconds
+    """
+    per_call = []
+    for _ in range(repeat):
+        start = time.perf_counter()
+        for _ in range(number):
+            function()
+        per_call.append((time.perf_counter() - start) / number * 1e6)
+    return {"best_us": min(per_call), "median_us": statistics.median(per_call)}
+
+
+def parse_snippet(code: str, args: list) -> clang.cindex.TranslationUnit:
+    """Parse an in-memory C++ snippet with the given compiler arguments."""
+    index = clang.cindex.Index.create()
+    return index.parse(
+        "bench_snippet.cpp", args=args, unsaved_files=[("bench_snippet.cpp", code)]
+    )
+
+
+def find_var_types(translation_unit, filename: str) -> list:
+    """Return the canonical types of all variables declared in `filename`."""
+    types = []
+    for cursor in translation_unit.cursor.walk_preorder():
+        if (
+            cursor.kind == clang.cindex.CursorKind.VAR_DECL
+            and cursor.location.file
+            and cursor.location.file.name == filename
+        ):
+            types.append(cursor.type.get_canonical())
+    return types
+
+
+def bench_analyze_var_decl(source_file: str, args: list, repeat: int) -> dict:
+    index = clang.cindex.Index.create()
+    translation_unit = index.parse(source_file, args=args)
+    with open(source_file, "r", encoding="utf-8") as f:
+        source_lines = f.readlines()
+    cursors = [
+        cursor
+        for cursor in translation_unit.cursor.walk_preorder()
+        if cursor.kind == clang.cindex.CursorKind.VAR_DECL
+        and cursor.location.file
+        and cursor.location.file.name == source_file
+    ]
+
+    def run():
+        # Measure the uncached classification path every time
+        checker._CLASSIFICATION_CACHE.clear()
+        for cursor in cursors:
+            checker.analyze_var_decl(cursor, source_file, source_lines)
+
+    result = measure(run, repeat, 3)
+    result["items"] = len(cursors)
+    return result
+
+
+def bench_is_in_eigen_namespace(args: list, repeat: int) -> dict:
+    opening = "".join(f"namespace n{i} {{ " for i in range(NAMESPACE_DEPTH))
+    closing = "} " * NAMESPACE_DEPTH
+    code = (
+        f"namespace Eigen {{ {opening} struct Deep {{}}; {closing} }}\n"
+        f"namespace other {{ {opening} struct Deep {{}}; {closing} }}\n"
+        f"Eigen::{'::'.join(f'n{i}' for i in range(NAMESPACE_DEPTH))}::Deep in_eigen;\n"
+        f"other::{'::'.join(f'n{i}' for i in range(NAMESPACE_DEPTH))}::Deep outside;\n"
+    )
+    types = find_var_types(parse_snippet(code, args), "bench_snippet.cpp")
+
+    def run():
+        for type_obj in types:
+            checker.is_in_eigen_namespace(type_obj)
+
+    result = measure(run, repeat, 200)
+    result["items"] = len(types)
+    return result
+
+
+def bench_is_allowed_auto_type(args: list, repeat: int) -> dict:
+    terms = " + ".join(
+        "A * B" if i % 2 else "A.transpose()" for i in range(EXPRESSION_TERMS)
+    )
+    code = (
+        "#include <Eigen/Core>\n"
+        "void f(const Eigen::MatrixXd& A, const Eigen::MatrixXd& B) {\n"
+        f"    auto expression = {terms};\n"
+        "    const auto& reference = expression;\n"
+        "    auto plain = (A * B).eval();\n"
+        "}\n"
+    )
+    types = find_var_types(parse_snippet(code, args), "bench_snippet.cpp")
+
+    def run():
+        for type_obj in types:
+            checker.is_allowed_auto_type(type_obj)
+
+    result = measure(run, repeat, 200)
+    result["items"] = len(types)
+    result["max_spelling_bytes"] = max(len(t.spelling) for t in types)
+    return result
+
+
+def bench_get_compile_args(repeat: int) -> dict:
+    with tempfile.TemporaryDirectory() as build_dir:
+        entries = [
+            {
+                "directory": build_dir,
+                "command": f"c++ -std=c++20 -Iinclude -DUNIT={i} -o tu{i}.o -c /src/tu{i}.cpp",
+                "file": f"/src/tu{i}.cpp",
+            }
+            for i in range(COMPDB_ENTRIES)
+        ]
+        with open(Path(build_dir) / "compile_commands.json", "w") as f:
+            json.dump(entries, f)
+
+        load_start = time.perf_counter()
+        compdb = checker.load_compilation_database(build_dir)
+        load_seconds = time.perf_counter() - load_start
+
+        probes = [f"/src/tu{i}.cpp" for i in range(0, COMPDB_ENTRIES, COMPDB_ENTRIES // 10)]
+
+        def run():
+            for probe in probes:
+                checker.get_compile_args(compdb, probe)
+
+        result = measure(run, repeat, 1)
+        result["items"] = len(probes)
+        result["load_s"] = load_seconds
+        return result
+
+
+def bench_get_source_range(repeat: int) -> dict:
+    lines = [f"    double value{i} = {i} * 2.0;  // line {i}\n" for i in range(LARGE_FILE_LINES)]
+    ranges = [(i, i + 4) for i in range(1, LARGE_FILE_LINES - 4, LARGE_FILE_LINES // 1000)]
+
+    def run():
+        for start_line, end_line in ranges:
+            checker.get_source_range(lines, start_line, end_line)
+
+    result = measure(run, repeat, 10)
+    result["items"] = len(ranges)
+    return result
+
+
+def parse_source(source_file: str, args: list) -> tuple:
+    """Parse a source file; return its translation unit and lines."""
+    index = clang.cindex.Index.create()
+    translation_unit = index.parse(source_file, args=args)
+    with open(source_file, "r", encoding="utf-8") as f:
+        source_lines = f.readlines()
+    return translation_unit, source_lines
+
+
+def bench_function_fingerprint(source_file: str, args: list, repeat: int) -> dict:
+    translation_unit, source_lines = parse_source(source_file, args)
+    functions = [
+        cursor
+        for cursor in translation_unit.cursor.walk_preorder()
+        if cursor.kind in check_registry.FUNCTION_KINDS
+        and cursor.is_definition()
+        and cursor.location.file
+        and cursor.location.file.name == source_file
+    ]
+
+    def run():
+        for cursor in functions:
+            check_registry.function_fingerprint(cursor, source_lines)
+
+    result = measure(run, repeat, 10)
+    result["items"] = len(functions)
+    return result
+
+
+def bench_run_checks_cached(source_file: str, args: list, repeat: int) -> dict:
+    translation_unit, source_lines = parse_source(source_file, args)
+    checks = checker.select_checks("*")
+    function_cache = check_registry.FunctionCache()
+    check_registry.run_checks(
+        translation_unit, source_file, source_lines, checks, function_cache=function_cache
+    )
+
+    def run():
+        check_registry.run_checks(
+            translation_unit,
+            source_file,
+            source_lines,
+            checks,
+            function_cache=function_cache,
+        )
+
+    result = measure(run, repeat, 1)
+    result["items"] = len(function_cache.entries)
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Microbenchmarks for the checker's hot functions"
+    )
+    parser.add_argument("source_file", help="C++ file to pre-parse, e.g. ../examples.cpp")
+    parser.add_argument("build_dir", help="Build directory containing compile_commands.json")
+    parser.add_argument("--repeat", type=int, default=5, help="Rounds per benchmark")
+    parser.add_argument(
+        "--only", action="append", help="Run only the named benchmark (repeatable)"
+    )
+    parser.add_argument("--json", metavar="FILE", help="Write results as JSON")
+    args = parser.parse_args()
+
+    source_file = str(Path(args.source_file).resolve())
+    compdb = checker.load_compilation_database(args.build_dir)
+    compile_args = checker.get_compile_args(compdb, source_file)
+
+    benchmarks = {
+        "analyze_var_decl": lambda: bench_analyze_var_decl(
+            source_file, compile_args, args.repeat
+        ),
+        "is_in_eigen_namespace": lambda: bench_is_in_eigen_namespace(
+            compile_args, args.repeat
+        ),
+        "is_allowed_auto_type": lambda: bench_is_allowed_auto_type(
+            compile_args, args.repeat
+        ),
+        "get_compile_args": lambda: bench_get_compile_args(args.repeat),
+        "get_source_range": lambda: bench_get_source_range(args.repeat),
+        "function_fingerprint": lambda: bench_function_fingerprint(
+            source_file, compile_args, args.repeat
+        ),
+        "run_checks_cached": lambda: bench_run_checks_cached(
+            source_file, compile_args, args.repeat
+        ),
+    }
+    selected = args.only or list(benchmarks)
+    unknown = [name for name in selected if name not in benchmarks]
+    if unknown:
+        parser.error(f"unknown benchmark(s): {', '.join(unknown)}")
+
+    results = {}
+    print(f"{'benchmark':<24} {'best':>12} {'median':>12} {'items':>7}")
+    for name in selected:
+        result = benchmarks[name]()
+        results[name] = result
+        print(
+            f"{name:<24} {result['best_us']:10.1f}us {result['median_us']:10.1f}us "
+            f"{result['items']:>7}"
+        )
+
+    if args.json:
+        with open(args.json, "w", encoding="utf-8") as f:
+            json.dump(results, f, indent=2)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""
+Compare pinned and unpinned workers of `eigen_auto_check.py --all`.
+
+Runs the checker on a synthetic project once per backend and --pin mode
+(none, node, cpu), each in a fresh interpreter, and reports the median wall
+time and CPU time, the peak RSS of the largest process and of all checker
+processes together, and the speedup over unpinned workers of the same
+backend. Pinning only pays off with several NUMA nodes and more
+workers than fit on one node; the detected topology is printed first.
+
+Usage:
+    uv run synthetic_project.py /tmp/synth --tus 1000
+    uv run bench_placement.py /tmp/synth/build --jobs 32 --repetitions 5
+"""
+
+import argparse
+import os
+import statistics
+
+from affinity import PIN_MODES, numa_nodes
+from bench_backends import run_backend
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Benchmark pinned against unpinned workers of --all"
+    )
+    parser.add_argument("build_dir", help="Directory containing compile_commands.json")
+    parser.add_argument(
+        "--jobs", "-j", type=int, default=os.cpu_count() or 1, help="Workers"
+    )
+    parser.add_argument(
+        "--repetitions", type=int, default=3, help="Runs per configuration"
+    )
+    parser.add_argument(
+        "--backend",
+        choices=("threads", "processes"),
+        action="append",
+        help="Backend to measure; repeat for both (default: both)",
+    )
+    args = parser.parse_args()
+
+    nodes = numa_nodes()
+    print(
+        f"{len(nodes)} NUMA node(s): "
+        + ", ".join(f"node {node} {len(cpus)} CPU(s)" for node, cpus in nodes.items())
+    )
+
+    print(
+        f"{'backend':<12} {'pin':<6} {'wall':>9} {'cpu':>9} {'peak RSS':>11} "
+        f"{'total RSS':>11} {'speedup':>8}"
+    )
+    for backend in args.backend or ["threads", "processes"]:
+        unpinned = None
+        for pin in PIN_MODES:
+            runs = [
+                run_backend(args.build_dir, backend, args.jobs, pin)
+                for _ in range(args.repetitions)
+            ]
+            wall = statistics.median(r["wall_s"] for r in runs)
+            cpu = statistics.median(r["cpu_s"] for r in runs)
+            rss = max(r["peak_rss_mib"] for r in runs)
+            total_rss = max(r["peak_total_rss_mib"] for r in runs)
+            if unpinned is None:
+                unpinned = wall
+            print(
+                f"{backend:<12} {pin:<6} {wall:8.2f}s {cpu:8.2f}s "
+                f"{rss:8.1f} MiB {total_rss:8.1f} MiB {unpinned / wall:7.2f}x"
+            )
+
+
+if __name__ == "__main__":
+    main()
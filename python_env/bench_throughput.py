@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+"""
+Measure checker throughput on a synthetic project.
+
+Runs `eigen_auto_check.py --all` on a project generated by
+synthetic_project.py and records files/s, declarations/s and peak RSS per
+repetition. Results are written as JSON together with the git commit and the
+project parameters, so runs from different commits can be compared.
+
+Usage:
+    uv run synthetic_project.py /tmp/synth --tus 200
+    uv run bench_throughput.py /tmp/synth --output bench-$(git rev-parse --short HEAD).json
+"""
+
+import argparse
+import json
+import os
+import re
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+CHECKER = Path(__file__).resolve().parent / "eigen_auto_check.py"
+
+_FOUND_RE = re.compile(r"^Found (\d+) issue\(s\)", re.MULTILINE)
+
+
+def git_commit() -> str:
+    """Return the current commit hash, or "unknown" outside a git checkout."""
+    result = subprocess.run(
+        ["git", "rev-parse", "HEAD"],
+        cwd=CHECKER.parent,
+        capture_output=True,
+        text=True,
+    )
+    return result.stdout.strip() if result.returncode == 0 else "unknown"
+
+
+def run_checker(build_dir: Path, extra_args: list) -> dict:
+    """
+    Run the checker once in a fresh process.
+
+    Returns:
+        Dict with wall time, peak RSS of the checker process tree and the
+        number of findings
+    """
+    with tempfile.TemporaryFile(mode="w+") as stdout, tempfile.TemporaryFile(
+        mode="w+"
+    ) as stderr:
+        start = time.perf_counter()
+        process = subprocess.Popen(
+            [sys.executable, str(CHECKER), "--all", str(build_dir), *extra_args],
+            stdout=stdout,
+            stderr=stderr,
+        )
+        # wait4 reports the rusage of this child, including any worker
+        # processes it reaped, instead of the totals of all our children
+        _, status, rusage = os.wait4(process.pid, 0)
+        wall = time.perf_counter() - start
+        process.returncode = os.waitstatus_to_exitcode(status)
+
+        stdout.seek(0)
+        stderr.seek(0)
+        output = stdout.read()
+        if process.returncode not in (0, 1):
+            raise RuntimeError(f"checker failed:\n{stderr.read()}")
+
+    match = _FOUND_RE.search(output)
+    return {
+        "wall_s": wall,
+        # ru_maxrss is in KiB on Linux
+        "peak_rss_mib": rusage.ru_maxrss / 1024,
+        "findings": int(match.group(1)) if match else 0,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Benchmark checker throughput on a synthetic project"
+    )
+    parser.add_argument(
+        "project", help="Directory written by synthetic_project.py"
+    )
+    parser.add_argument(
+        "--output", "-o", help="Write results as JSON to this file"
+    )
+    parser.add_argument(
+        "--repetitions", type=int, default=3, help="Runs to record (default: 3)"
+    )
+    parser.add_argument(
+        "--jobs", "-j", type=int, default=os.cpu_count() or 1, help="Workers"
+    )
+    parser.add_argument(
+        "--backend", choices=("threads", "processes"), default="threads"
+    )
+    parser.add_argument("--checks", default="*", help="Check filter")
+    args = parser.parse_args()
+
+    project = Path(args.project).resolve()
+    with open(project / "synthetic_project.json", encoding="utf-8") as f:
+        manifest = json.load(f)
+
+    checker_args = [
+        "--jobs",
+        str(args.jobs),
+        "--backend",
+        args.backend,
+        f"--checks={args.checks}",
+    ]
+
+    runs = []
+    for repetition in range(args.repetitions):
+        run = run_checker(project / "build", checker_args)
+        run["files_per_s"] = manifest["tus"] / run["wall_s"]
+        run["declarations_per_s"] = manifest["declarations"] / run["wall_s"]
+        runs.append(run)
+        print(
+            f"run {repetition + 1}: {run['wall_s']:.2f}s, "
+            f"{run['files_per_s']:.2f} files/s, "
+            f"{run['declarations_per_s']:.1f} decls/s, "
+            f"peak RSS {run['peak_rss_mib']:.1f} MiB"
+        )
+        if run["findings"] != manifest["expected_findings"]:
+            print(
+                f"warning: {run['findings']} finding(s), expected "
+                f"{manifest['expected_findings']}",
+                file=sys.stderr,
+            )
+
+    results = {
+        "commit": git_commit(),
+        "timestamp": time.strftime("%Y-%m-%dT%H:%M:%S%z"),
+        "project": manifest,
+        "jobs": args.jobs,
+        "backend": args.backend,
+        "checks": args.checks,
+        "runs": runs,
+        "median": {
+            key: statistics.median(run[key] for run in runs)
+            for key in ("wall_s", "files_per_s", "declarations_per_s", "peak_rss_mib")
+        },
+    }
+
+    if args.output:
+        with open(args.output, "w", encoding="utf-8") as f:
+            json.dump(results, f, indent=2)
+        print(f"Results written to {args.output}")
+
+
+if __name__ == "__main__":
+    main()
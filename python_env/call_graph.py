@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+"""
+Cross-TU call graph used to rank findings by how hot their code is.
+
+While a translation unit is checked, CallGraphCollector records one edge per
+call site (caller USR -> callee USR, loop depth at the call site). After a
+whole-project run the per-TU edges are merged into a single graph and a
+hotness score is propagated from callers to callees: every loop enclosing a
+call site multiplies the callee's hotness by LOOP_WEIGHT. A finding's score is
+the hotness of its enclosing function times LOOP_WEIGHT per loop around the
+finding itself.
+
+Entry points -- `main` and externally visible functions that no project code
+calls -- start at ENTRY_HOTNESS, since a caller outside the project may run
+them at any time. Findings only reachable from cold code (functions with
+internal linkage that nothing calls, and their callees) keep a score of 1 and
+are reported as warnings.
+"""
+
+import json
+
+import clang.cindex
+
+from check_registry import FUNCTION_KINDS, Check, enclosing_function
+
+# Assumed iteration count of a loop whose trip count is unknown
+LOOP_WEIGHT = 10.0
+
+# Upper bound on hotness so that recursion cannot grow scores forever
+MAX_HOTNESS = 1e12
+
+# Scores at or below this are considered cold
+COLD_HOTNESS = 1.0
+
+# Base score of entry points; above COLD_HOTNESS so their findings are errors
+ENTRY_HOTNESS = 2.0
+
+# Pseudo caller of entry point candidates in the edge lists
+ENTRY_CALLER = "<entry>"
+
+
+class CallGraphCollector(Check):
+    """
+    Records call edges for the call graph; produces no findings.
+
+    Every definition of `main` or of an externally visible function also
+    gets an edge from ENTRY_CALLER, marking it as an entry point in case no
+    project code calls it.
+
+    Not registered: whole-project runs add an instance next to the selected
+    checks so the edges are collected during the same traversal.
+    """
+
+    name = "call-graph"
+    description = "collect caller -> callee edges for hotness ranking"
+    cursor_kinds = frozenset({clang.cindex.CursorKind.CALL_EXPR}) | FUNCTION_KINDS
+    incremental = False
+
+    def __init__(self):
+        self.edges = []
+
+    def visit(self, cursor, context):
+        if cursor.kind in FUNCTION_KINDS:
+            if cursor.is_definition() and (
+                cursor.spelling == "main"
+                or cursor.linkage == clang.cindex.LinkageKind.EXTERNAL
+            ):
+                self.edges.append(
+                    {"caller": ENTRY_CALLER, "callee": cursor.get_usr(), "loop_depth": 0}
+                )
+            return []
+
+        callee = cursor.referenced
+        if callee is None:
+            return []
+        # Calls into Eigen and the standard library cannot lead back into
+        # project code that we analyze, so keep the graph small
+        if callee.location.is_in_system_header:
+            return []
+
+        caller, loop_depth = enclosing_function(context.ancestors)
+        if caller is None:
+            return []
+
+        caller_usr = caller.get_usr()
+        callee_usr = callee.canonical.get_usr()
+        if caller_usr and callee_usr:
+            self.edges.append(
+                {"caller": caller_usr, "callee": callee_usr, "loop_depth": loop_depth}
+            )
+        return []
+
+    def export_state(self):
+        return self.edges
+
+    def import_state(self, state) -> None:
+        self.edges.extend(state or [])
+
+
+def merge_call_graph(edge_lists: list) -> dict:
+    """
+    Merge per-TU call edges into a project call graph.
+
+    Args:
+        edge_lists: Iterable of edge lists as produced by CallGraphCollector
+
+    Returns:
+        Dict mapping callee USR -> {caller USR: deepest loop depth of any call}
+    """
+    callers = {}
+    for edges in edge_lists:
+        for edge in edges:
+            by_caller = callers.setdefault(edge["callee"], {})
+            previous = by_caller.get(edge["caller"], -1)
+            by_caller[edge["caller"]] = max(previous, edge["loop_depth"])
+    return callers
+
+
+def propagate_hotness(callers: dict) -> dict:
+    """
+    Compute a hotness score for every function in the call graph.
+
+    Entry points (callees of ENTRY_CALLER that no project function calls)
+    start at ENTRY_HOTNESS, all other functions at 1. A callee is as hot as
+    its hottest call site, where a call site is the caller's hotness times
+    LOOP_WEIGHT per enclosing loop. Cycles are handled by relaxing to a fixed
+    point, bounded by MAX_HOTNESS.
+
+    Args:
+        callers: Graph from merge_call_graph()
+
+    Returns:
+        Dict mapping function USR -> hotness score (>= 1)
+    """
+    functions = set(callers)
+    for by_caller in callers.values():
+        functions.update(by_caller)
+    functions.discard(ENTRY_CALLER)
+
+    hotness = {usr: 1.0 for usr in functions}
+    project_callers = {}
+    for callee, by_caller in callers.items():
+        project_callers[callee] = {
+            caller: loop_depth
+            for caller, loop_depth in by_caller.items()
+            if caller != ENTRY_CALLER
+        }
+        if not project_callers[callee] and ENTRY_CALLER in by_caller:
+            hotness[callee] = ENTRY_HOTNESS
+
+    # Bellman-Ford style relaxation; each round can only raise scores
+    for _ in range(len(functions)):
+        changed = False
+        for callee, by_caller in project_callers.items():
+            best = hotness[callee]
+            for caller, loop_depth in by_caller.items():
+                candidate = min(
+                    hotness[caller] * LOOP_WEIGHT**loop_depth, MAX_HOTNESS
+                )
+                if candidate > best:
+                    best = candidate
+            if best > hotness[callee]:
+                hotness[callee] = best
+                changed = True
+        if not changed:
+            break
+
+    return hotness
+
+
+def rank_issues(issues: list, hotness: dict) -> list:
+    """
+    Attach a hotness score to each issue and sort hottest first.
+
+    Args:
+        issues: Issue dicts from run_checks()
+        hotness: Scores from propagate_hotness()
+
+    Returns:
+        The issues sorted by descending hotness (stable within equal scores)
+    """
+    for issue in issues:
+        base = hotness.get(issue.get("function"), COLD_HOTNESS)
+        issue["hotness"] = min(
+            base * LOOP_WEIGHT ** issue.get("loop_depth", 0), MAX_HOTNESS
+        )
+    return sorted(issues, key=lambda issue: -issue["hotness"])
+
+
+def write_call_graph(path: str, callers: dict, hotness: dict) -> None:
+    """Write the merged call graph and hotness scores as JSON."""
+    edges = [
+        {"caller": caller, "callee": callee, "loop_depth": loop_depth}
+        for callee, by_caller in sorted(callers.items())
+        for caller, loop_depth in sorted(by_caller.items())
+    ]
+    with open(path, "w", encoding="utf-8") as f:
+        json.dump({"edges": edges, "hotness": hotness}, f, indent=2, sort_keys=True)
@@ -0,0 +1,478 @@
+#!/usr/bin/env python3
+"""
+Registry of checks that share a single parse and a single AST traversal.
+
+Each check declares the cursor kinds it is interested in. run_checks() walks a
+translation unit once, prunes subtrees that live outside the file being checked,
+and dispatches every remaining cursor to the checks registered for its kind.
+
+Adding a new analysis therefore costs one dictionary lookup per node instead of
+another full walk of the AST.
+"""
+
+import copy
+import fnmatch
+import hashlib
+import time
+
+import clang.cindex
+
+
+class CheckContext:
+    """State shared by all checks while analyzing one translation unit."""
+
+    # A plain class rather than a dataclass: importing dataclasses (and with it
+    # inspect) is a measurable part of the checker's cold start
+    __slots__ = ("filename", "source_lines", "translation_unit", "ancestors", "state")
+
+    def __init__(
+        self,
+        filename: str,
+        source_lines: list,
+        translation_unit: clang.cindex.TranslationUnit,
+        ancestors: list = None,
+        state: dict = None,
+    ):
+        self.filename = filename
+        self.source_lines = source_lines
+        self.translation_unit = translation_unit
+        # Ancestors of the cursor currently being visited, outermost first
+        self.ancestors = [] if ancestors is None else ancestors
+        # Scratch space for checks that need to carry state across nodes
+        self.state = {} if state is None else state
+
+
+class Check:
+    """
+    Base class for checks run by run_checks().
+
+    Subclasses set `name`, `description` and `cursor_kinds`, and override
+    visit() (called once per matching cursor) and optionally
+    begin_translation_unit()/end_translation_unit() for checks that collect
+    information over the whole TU before reporting (e.g. dataflow checks).
+    """
+
+    name = ""
+    description = ""
+    cursor_kinds = frozenset()
+    # Expensive checks (dataflow, whole-TU) are skipped by --checks=-expensive
+    expensive = False
+    # Findings depend only on the enclosing function, so they can be reused
+    # from a FunctionCache while the function's fingerprint is unchanged
+    incremental = True
+
+    def begin_translation_unit(self, context: CheckContext) -> None:
+        pass
+
+    def visit(self, cursor: clang.cindex.Cursor, context: CheckContext) -> list:
+        return []
+
+    def end_translation_unit(self, context: CheckContext) -> list:
+        return []
+
+    def export_state(self):
+        """
+        Return JSON-serializable per-TU results other than findings, so that
+        a cached analysis can restore them with import_state().
+        """
+        return None
+
+    def import_state(self, state) -> None:
+        pass
+
+
+FUNCTION_KINDS = frozenset(
+    {
+        clang.cindex.CursorKind.FUNCTION_DECL,
+        clang.cindex.CursorKind.CXX_METHOD,
+        clang.cindex.CursorKind.CONSTRUCTOR,
+        clang.cindex.CursorKind.DESTRUCTOR,
+        clang.cindex.CursorKind.CONVERSION_FUNCTION,
+        clang.cindex.CursorKind.FUNCTION_TEMPLATE,
+    }
+)
+
+LOOP_KINDS = frozenset(
+    {
+        clang.cindex.CursorKind.FOR_STMT,
+        clang.cindex.CursorKind.CXX_FOR_RANGE_STMT,
+        clang.cindex.CursorKind.WHILE_STMT,
+        clang.cindex.CursorKind.DO_STMT,
+    }
+)
+
+
+def enclosing_function(ancestors: list):
+    """
+    Find the innermost function enclosing a cursor and its loop depth.
+
+    Args:
+        ancestors: Ancestor cursors, outermost first (CheckContext.ancestors)
+
+    Returns:
+        Tuple (function cursor or None, number of loops between the function
+        and the cursor)
+    """
+    loop_depth = 0
+    for ancestor in reversed(ancestors):
+        if ancestor.kind in FUNCTION_KINDS:
+            return ancestor, loop_depth
+        if ancestor.kind in LOOP_KINDS:
+            loop_depth += 1
+    return None, loop_depth
+
+
+def function_fingerprint(cursor: clang.cindex.Cursor, source_lines: list) -> str:
+    """
+    Fingerprint the source text of a function definition.
+
+    The hash covers the lines of the function's extent and the columns it
+    starts and ends at, but not its line numbers, so moving the whole
+    function does not change it. Changes outside the function that alter its
+    deduced types (a typedef, a header) are caught by the type digest that
+    run_checks() computes during its walk instead.
+
+    Args:
+        cursor: A function definition cursor
+        source_lines: Lines of the file containing the function
+
+    Returns:
+        Hex digest identifying the function's text
+    """
+    start = cursor.extent.start
+    end = cursor.extent.end
+    digest = hashlib.blake2b(digest_size=16)
+    digest.update(f"{start.column}:{end.column}\0".encode())
+    digest.update("".join(source_lines[start.line - 1 : end.line]).encode())
+    return digest.hexdigest()
+
+
+# Nodes whose canonical types make up a function's type digest
+_FINGERPRINT_TYPE_KINDS = frozenset(
+    {
+        clang.cindex.CursorKind.VAR_DECL,
+        clang.cindex.CursorKind.PARM_DECL,
+        clang.cindex.CursorKind.DECL_REF_EXPR,
+        clang.cindex.CursorKind.CALL_EXPR,
+    }
+)
+
+
+class FunctionCache:
+    """
+    Findings of incremental checks keyed by function, for watch/daemon mode.
+
+    Each entry stores the function's text fingerprint, the digest of the
+    canonical types it uses and its findings with line numbers relative to
+    the function start. Pass the same instance to run_checks() on every
+    re-analysis of a file.
+    """
+
+    def __init__(self):
+        self.entries = {}
+        self.hits = 0
+        self.misses = 0
+
+    def lookup(self, usr: str, fingerprint: str):
+        """
+        Find the entry of a function whose text is unchanged.
+
+        Returns:
+            Tuple (type digest, relative issues), or None
+        """
+        entry = self.entries.get(usr)
+        if entry is not None and entry[0] == fingerprint:
+            return entry[1:]
+        return None
+
+    def store(
+        self, usr: str, fingerprint: str, type_digest: str, relative_issues: list
+    ) -> None:
+        self.entries[usr] = (fingerprint, type_digest, relative_issues)
+
+    def retain(self, usrs: set) -> None:
+        """Drop entries for functions that no longer exist."""
+        for usr in list(self.entries):
+            if usr not in usrs:
+                del self.entries[usr]
+
+
+class _FunctionVisit:
+    """A function definition being walked by run_checks() with a FunctionCache."""
+
+    __slots__ = (
+        "cursor",
+        "depth",
+        "ancestors",
+        "usr",
+        "fingerprint",
+        "start_line",
+        "first_issue",
+        "types",
+        "cached",
+    )
+
+    def __init__(
+        self, cursor, depth: int, ancestors: list, source_lines: list, first_issue: int
+    ):
+        self.cursor = cursor
+        self.depth = depth
+        self.ancestors = list(ancestors)
+        self.usr = cursor.get_usr()
+        self.fingerprint = function_fingerprint(cursor, source_lines)
+        self.start_line = cursor.extent.start.line
+        # Index in the issue list where the function's findings begin
+        self.first_issue = first_issue
+        # Digest of the canonical types used in the function, fed by the walk
+        self.types = hashlib.blake2b(digest_size=16)
+        # (type digest, relative issues) from the cache, if the text matches
+        self.cached = None
+
+
+_REGISTRY = {}
+
+
+def register_check(cls):
+    """Class decorator adding a Check subclass to the registry."""
+    if not cls.name:
+        raise ValueError(f"Check {cls.__name__} has no name")
+    if cls.name in _REGISTRY:
+        raise ValueError(f"Duplicate check name: {cls.name}")
+    _REGISTRY[cls.name] = cls
+    return cls
+
+
+def available_checks() -> dict:
+    """Return a name -> Check class mapping of all registered checks."""
+    return dict(_REGISTRY)
+
+
+def select_checks(spec: str) -> list:
+    """
+    Instantiate the checks selected by a clang-tidy style filter.
+
+    The filter is a comma-separated list of glob patterns applied in order.
+    A pattern prefixed with '-' removes matching checks; the special pattern
+    'expensive' matches every check marked as expensive. An empty filter
+    selects all checks.
+
+    Args:
+        spec: Filter string, e.g. "*", "eigen-*", "*,-expensive"
+
+    Returns:
+        List of Check instances in registration order
+    """
+    patterns = [p.strip() for p in (spec or "*").split(",") if p.strip()]
+    if patterns and all(p.startswith("-") for p in patterns):
+        patterns.insert(0, "*")
+
+    enabled = set()
+    for pattern in patterns:
+        remove = pattern.startswith("-")
+        pattern = pattern.removeprefix("-")
+        matched = set()
+        for name, cls in _REGISTRY.items():
+            if pattern == "expensive":
+                if cls.expensive:
+                    matched.add(name)
+            elif fnmatch.fnmatchcase(name, pattern):
+                matched.add(name)
+        if not matched and not remove and pattern != "expensive":
+            raise ValueError(f"Unknown check: {pattern}")
+        if remove:
+            enabled -= matched
+        else:
+            enabled |= matched
+
+    return [cls() for name, cls in _REGISTRY.items() if name in enabled]
+
+
+def run_checks(
+    translation_unit: clang.cindex.TranslationUnit,
+    filename: str,
+    source_lines: list,
+    checks: list,
+    timings: dict = None,
+    function_cache: FunctionCache = None,
+) -> list:
+    """
+    Run all checks over a translation unit in a single traversal.
+
+    Top-level declarations that do not originate from `filename` (i.e. all of
+    the included headers) are pruned without descending into them.
+
+    Args:
+        translation_unit: Parsed translation unit
+        filename: The main file; only its declarations are visited
+        source_lines: Lines of the main file, for source snippets
+        checks: Check instances from select_checks()
+        timings: Optional dict accumulating seconds per check name
+            plus a "traversal" entry for the walk itself
+        function_cache: Optional FunctionCache; function definitions whose
+            text and types are unchanged reuse their previous findings and
+            are only walked for checks that are not incremental
+
+    Returns:
+        List of issue dicts; each carries the name of its check under "check"
+        and, when reported during the walk, the USR of its enclosing function
+        under "function" and its loop depth within it under "loop_depth"
+    """
+    issues = []
+    context = CheckContext(filename, source_lines, translation_unit)
+    spent = {check.name: 0.0 for check in checks}
+
+    # Map cursor kind -> checks interested in it
+    dispatch = {}
+    for check in checks:
+        for kind in check.cursor_kinds:
+            dispatch.setdefault(kind, []).append(check)
+
+    # Function definition currently being walked with the cache, see below
+    walking = None
+    # The function's findings are being recorded for the cache; None while
+    # its cached findings are tentatively reused
+    recording = None
+    seen_functions = set()
+    non_incremental = {
+        kind: [check for check in interested if not check.incremental]
+        for kind, interested in dispatch.items()
+    }
+    incremental = {
+        kind: [check for check in interested if check.incremental]
+        for kind, interested in dispatch.items()
+    }
+
+    def report(check, found):
+        if not found:
+            return
+        function, loop_depth = enclosing_function(context.ancestors)
+        for issue in found:
+            issue.setdefault("check", check.name)
+            if function is not None and "function" not in issue:
+                issue["function"] = function.get_usr()
+                issue["loop_depth"] = loop_depth
+            if recording is not None and check.incremental:
+                relative = copy.deepcopy(issue)
+                relative["line"] -= walking.start_line
+                recording.append(relative)
+        issues.extend(found)
+
+    def visit_subtree(root, root_depth, kinds):
+        """Dispatch a subtree to the checks in `kinds`, without the cache."""
+        subtree = [(root, root_depth)]
+        while subtree:
+            cursor, depth = subtree.pop()
+            del path[depth:]
+            for check in kinds.get(cursor.kind, ()):
+                start = time.perf_counter()
+                report(check, check.visit(cursor, context))
+                spent[check.name] += time.perf_counter() - start
+            path.append(cursor)
+            children = [(child, depth + 1) for child in cursor.get_children()]
+            children.reverse()
+            subtree.extend(children)
+
+    def finish_function():
+        """Reuse or store the findings of the function just walked."""
+        nonlocal recording
+        type_digest = walking.types.hexdigest()
+        if walking.cached is not None and walking.cached[0] == type_digest:
+            function_cache.hits += 1
+            reused = []
+            for relative in walking.cached[1]:
+                issue = copy.deepcopy(relative)
+                issue["line"] += walking.start_line
+                reused.append(issue)
+            # Where they would have been reported during the walk
+            issues[walking.first_issue : walking.first_issue] = reused
+            return
+        function_cache.misses += 1
+        if walking.cached is not None:
+            # Same text, different types: the incremental checks skipped the
+            # function, so visit it again for them
+            recording = []
+            saved_path = path[:]
+            path[:] = walking.ancestors
+            visit_subtree(walking.cursor, walking.depth, incremental)
+            path[:] = saved_path
+        function_cache.store(walking.usr, walking.fingerprint, type_digest, recording)
+        recording = None
+
+    for check in checks:
+        start = time.perf_counter()
+        check.begin_translation_unit(context)
+        spent[check.name] += time.perf_counter() - start
+
+    visits_before_walk = sum(spent.values())
+    walk_start = time.perf_counter()
+
+    # Only descend into top-level cursors that belong to the main file
+    stack = []
+    for child in translation_unit.cursor.get_children():
+        location_file = child.location.file
+        if location_file is not None and location_file.name == filename:
+            stack.append((child, 0))
+    stack.reverse()
+
+    path = context.ancestors
+    while stack:
+        cursor, depth = stack.pop()
+        del path[depth:]
+
+        if function_cache is not None:
+            if walking is not None and depth <= walking.depth:
+                finish_function()
+                walking = None
+            if (
+                walking is None
+                and cursor.kind in FUNCTION_KINDS
+                and cursor.is_definition()
+            ):
+                # The type digest is computed during this walk, so a function
+                # whose text is unchanged skips its incremental checks on the
+                # assumption that its types are too; finish_function() checks
+                walking = _FunctionVisit(cursor, depth, path, source_lines, len(issues))
+                seen_functions.add(walking.usr)
+                walking.cached = function_cache.lookup(walking.usr, walking.fingerprint)
+                if walking.cached is None:
+                    recording = []
+            elif walking is not None and cursor.kind in _FINGERPRINT_TYPE_KINDS:
+                walking.types.update(cursor.type.get_canonical().spelling.encode())
+                walking.types.update(b"\0")
+
+        if walking is not None and recording is None:
+            interested = non_incremental.get(cursor.kind)
+        else:
+            interested = dispatch.get(cursor.kind)
+        if interested:
+            for check in interested:
+                start = time.perf_counter()
+                report(check, check.visit(cursor, context))
+                spent[check.name] += time.perf_counter() - start
+        path.append(cursor)
+        children = [(child, depth + 1) for child in cursor.get_children()]
+        children.reverse()
+        stack.extend(children)
+    del path[:]
+
+    if function_cache is not None:
+        if walking is not None:
+            finish_function()
+        function_cache.retain(seen_functions)
+
+    walk_total = time.perf_counter() - walk_start
+    visits_during_walk = sum(spent.values()) - visits_before_walk
+
+    for check in checks:
+        start = time.perf_counter()
+        report(check, check.end_translation_unit(context))
+        spent[check.name] += time.perf_counter() - start
+
+    if timings is not None:
+        timings["traversal"] = timings.get("traversal", 0.0) + max(
+            walk_total - visits_during_walk, 0.0
+        )
+        for name, seconds in spent.items():
+            timings[name] = timings.get(name, 0.0) + seconds
+
+    return issues
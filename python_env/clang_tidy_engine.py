@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""
+Run the eigen-auto check through the native clang-tidy plugin.
+
+The plugin (built by the BUILD_CLANG_TIDY_PLUGIN CMake option from
+clang_tidy_plugin/) implements the same rule as analyze_var_decl() without
+the per-node ctypes overhead of walking the AST from Python. This module
+invokes `clang-tidy -load` and turns its diagnostics back into the issue
+dicts produced by the libclang engine.
+
+Only eigen-auto is implemented natively. eigen-tensor-device (tensor
+contractions evaluated on the default device) exists in the libclang engine
+only, so on files using the Tensor module the two engines report different
+findings.
+"""
+
+import re
+import subprocess
+from pathlib import Path
+
+from eigen_types import get_source_range
+
+CHECK_NAME = "eigen-auto"
+
+# Checks this engine implements; the others exist in the libclang engine only
+CHECKS = frozenset({CHECK_NAME})
+
+_WARNING_RE = re.compile(
+    r"^(?P<file>.+?):(?P<line>\d+):(?P<column>\d+): warning: "
+    r"'(?P<variable>[^']*)' uses (?:decltype\(auto\)|auto) "
+    r"with Eigen expression template \[" + CHECK_NAME + r"\]$"
+)
+
+_FIELDS_RE = re.compile(
+    r"^(?P<file>.+?):(?P<line>\d+):(?P<column>\d+): note: eigen-auto-fields: "
+    r"type=(?P<type>.*); type_as_written=(?P<type_as_written>.*); "
+    r"auto_kind=(?P<auto_kind>[^;]*); end_line=(?P<end_line>\d+)$"
+)
+
+
+def check_file_clang_tidy(
+    filename: str,
+    build_dir: str,
+    plugin: str,
+    source_lines: list,
+    clang_tidy: str = "clang-tidy",
+) -> list:
+    """
+    Check a file with the clang-tidy plugin.
+
+    Args:
+        filename: Absolute path of the source file
+        build_dir: Directory containing compile_commands.json
+        plugin: Path to EigenAutoCheckPlugin.so
+        source_lines: Lines of the source file, for source snippets
+        clang_tidy: clang-tidy executable
+
+    Returns:
+        List of issue dicts with the same fields as analyze_var_decl()
+    """
+    command = [
+        clang_tidy,
+        f"-load={plugin}",
+        f"-checks=-*,{CHECK_NAME}",
+        "-p",
+        str(Path(build_dir).resolve()),
+        "--quiet",
+        filename,
+    ]
+    try:
+        result = subprocess.run(command, capture_output=True, text=True)
+    except FileNotFoundError:
+        raise RuntimeError(f"clang-tidy executable not found: {clang_tidy}") from None
+    if result.returncode != 0 and "error:" in result.stderr:
+        raise RuntimeError(f"clang-tidy failed:\n{result.stderr}")
+
+    issues = []
+    pending = None
+    for line in result.stdout.splitlines():
+        match = _WARNING_RE.match(line)
+        if match:
+            pending = match
+            continue
+        match = _FIELDS_RE.match(line)
+        if match and pending is not None:
+            start_line = int(pending["line"])
+            issues.append(
+                {
+                    "file": pending["file"],
+                    "line": start_line,
+                    "column": int(pending["column"]),
+                    "variable": pending["variable"],
+                    "type": match["type"],
+                    "type_as_written": match["type_as_written"],
+                    "auto_kind": match["auto_kind"],
+                    "source": get_source_range(
+                        source_lines, start_line, int(match["end_line"])
+                    ),
+                    "check": CHECK_NAME,
+                }
+            )
+            pending = None
+
+    return issues
@@ -0,0 +1,325 @@
+#!/usr/bin/env python3
+"""
+Compilation database layer for large compile_commands.json files.
+
+libclang's loader parses and tokenizes the whole JSON on every start, even
+when a single file is checked. For monorepo databases of hundreds of MB that
+dominates small incremental runs. This module instead keeps a SQLite index
+next to the JSON (compile_commands.json.index):
+
+- the index is built once from the JSON and reused until the JSON's mtime or
+  size changes, so a warm start opens a file instead of parsing it;
+- paths are normalized once when the index is built, and queries are
+  normalized with the same function; each entry is also indexed under its
+  symlink-resolved path, so a file the database names through a symlinked
+  directory is found by its real path, as libclang's loader would;
+- a lookup is a primary-key query, so its cost does not depend on the number
+  of entries, and only the requested entries are ever materialized.
+
+If the build directory is read-only, the index is built in memory instead.
+
+A single-file run without a current index does not pay for building it:
+the entries of the requested file are located with a text search and only
+those are decoded (see from_directory(only_file=...)).
+"""
+
+import json
+import os
+import shlex
+import sqlite3
+import threading
+from pathlib import Path
+
+INDEX_SUFFIX = ".index"
+
+# Bump when the index layout changes
+INDEX_VERSION = "3"
+
+
+def normalize_path(directory: str, filename: str) -> str:
+    """
+    Normalize a compilation database path without touching the filesystem.
+
+    Args:
+        directory: The entry's working directory
+        filename: The entry's file, absolute or relative to directory
+
+    Returns:
+        Absolute, normalized path
+    """
+    return os.path.normpath(os.path.join(directory, filename))
+
+
+class _RealPaths:
+    """realpath() of normalized paths, resolving each directory only once."""
+
+    def __init__(self):
+        self._directories = {}
+
+    def __call__(self, path: str) -> str:
+        directory, name = os.path.split(path)
+        real_directory = self._directories.get(directory)
+        if real_directory is None:
+            real_directory = os.path.realpath(directory)
+            self._directories[directory] = real_directory
+        real_path = os.path.join(real_directory, name)
+        if os.path.islink(real_path):
+            real_path = os.path.realpath(real_path)
+        return real_path
+
+
+class CompileCommand:
+    """One compile command; mirrors clang.cindex.CompileCommand."""
+
+    __slots__ = ("directory", "filename", "arguments")
+
+    def __init__(self, directory: str, filename: str, arguments: list):
+        self.directory = directory
+        self.filename = filename
+        self.arguments = arguments
+
+
+def _create_schema(connection: sqlite3.Connection) -> None:
+    connection.executescript(
+        """
+        CREATE TABLE meta (key TEXT PRIMARY KEY, value TEXT) WITHOUT ROWID;
+        CREATE TABLE commands (
+            file TEXT NOT NULL,
+            seq INTEGER NOT NULL,
+            -- file with all symlinks resolved
+            real_file TEXT NOT NULL,
+            directory TEXT NOT NULL,
+            -- JSON argument list, or NULL when only a shell command is given
+            arguments TEXT,
+            command TEXT,
+            PRIMARY KEY (file, seq)
+        ) WITHOUT ROWID;
+        CREATE INDEX commands_real_file ON commands (real_file);
+        """
+    )
+
+
+def _fill_index(connection: sqlite3.Connection, entries: list, stat) -> None:
+    seq_by_file = {}
+    rows = []
+    real_paths = _RealPaths()
+    for entry in entries:
+        path = normalize_path(entry["directory"], entry["file"])
+        seq = seq_by_file.get(path, 0)
+        seq_by_file[path] = seq + 1
+        # Shell commands are split lazily on lookup; shlex is far too slow to
+        # run over every entry of a large database while building the index
+        arguments = entry.get("arguments")
+        rows.append(
+            (
+                path,
+                seq,
+                real_paths(path),
+                entry["directory"],
+                json.dumps(arguments) if arguments is not None else None,
+                entry.get("command"),
+            )
+        )
+
+    connection.executemany("INSERT INTO commands VALUES (?, ?, ?, ?, ?, ?)", rows)
+    connection.executemany(
+        "INSERT INTO meta VALUES (?, ?)",
+        [
+            ("version", INDEX_VERSION),
+            ("mtime_ns", str(stat.st_mtime_ns)),
+            ("size", str(stat.st_size)),
+        ],
+    )
+    connection.commit()
+
+
+def _load_entries(json_path: Path) -> list:
+    with open(json_path, "r", encoding="utf-8") as f:
+        return json.load(f)
+
+
+def _scan_entries(json_path: Path, filename: str):
+    """
+    Find the entries of one file without decoding the whole database.
+
+    Every occurrence of the file's base name is located by plain text search
+    and the JSON object around it is decoded on its own. An entry matches if
+    it names the file or, through symlinks, the same real file.
+
+    Returns:
+        List of matching entries in database order, or None if there are none
+        or the text could not be interpreted (use the full index then)
+    """
+    with open(json_path, "r", encoding="utf-8") as f:
+        text = f.read()
+    decoder = json.JSONDecoder()
+    needle = json.dumps(os.path.basename(filename))[1:-1]
+    real_filename = os.path.realpath(filename)
+    entries = []
+    starts = set()
+    position = text.find(needle)
+    while position != -1:
+        # Entries are flat objects, so the nearest "{" before the match opens it
+        start = text.rfind("{", 0, position)
+        if start == -1:
+            return None
+        if start not in starts:
+            starts.add(start)
+            try:
+                entry, _ = decoder.raw_decode(text, start)
+            except ValueError:
+                return None
+            if not isinstance(entry, dict) or "file" not in entry or "directory" not in entry:
+                return None
+            path = normalize_path(entry["directory"], entry["file"])
+            if path == filename or os.path.realpath(path) == real_filename:
+                entries.append(entry)
+        position = text.find(needle, position + len(needle))
+    return entries or None
+
+
+def _index_is_current(connection: sqlite3.Connection, stat) -> bool:
+    try:
+        meta = dict(connection.execute("SELECT key, value FROM meta"))
+    except sqlite3.DatabaseError:
+        return False
+    return meta == {
+        "version": INDEX_VERSION,
+        "mtime_ns": str(stat.st_mtime_ns),
+        "size": str(stat.st_size),
+    }
+
+
+class CompilationDatabase:
+    """
+    Indexed view of a compile_commands.json.
+
+    Use CompilationDatabase.from_directory(); the object can be shared between
+    threads (lookups are serialized on one SQLite connection).
+    """
+
+    def __init__(self, connection: sqlite3.Connection, index_path: str = None):
+        self._connection = connection
+        self._lock = threading.Lock()
+        self.index_path = index_path
+        # True when the index had to be (re)built from the JSON on this load
+        self.rebuilt = False
+        # True when only the entries of one file were loaded
+        self.partial = False
+
+    @classmethod
+    def from_directory(cls, build_dir: str, only_file: str = None) -> "CompilationDatabase":
+        """
+        Open the database of a build directory, building its index if needed.
+
+        Args:
+            build_dir: Directory containing compile_commands.json
+            only_file: If given and the index is not current, load just this
+                file's entries into memory instead of building the index
+
+        Returns:
+            CompilationDatabase object
+        """
+        json_path = Path(build_dir) / "compile_commands.json"
+        stat = json_path.stat()
+        index_path = json_path.with_name(json_path.name + INDEX_SUFFIX)
+
+        if index_path.exists():
+            connection = sqlite3.connect(
+                f"file:{index_path}?mode=ro", uri=True, check_same_thread=False
+            )
+            if _index_is_current(connection, stat):
+                return cls(connection, str(index_path))
+            connection.close()
+
+        if only_file is not None:
+            entries = _scan_entries(json_path, os.path.normpath(os.path.abspath(only_file)))
+            if entries is not None:
+                connection = sqlite3.connect(":memory:", check_same_thread=False)
+                _create_schema(connection)
+                _fill_index(connection, entries, stat)
+                database = cls(connection)
+                database.partial = True
+                return database
+
+        import tempfile
+
+        # Build into a temporary file and rename it into place so concurrent
+        # readers never see a partially written index
+        try:
+            fd, tmp_path = tempfile.mkstemp(
+                prefix=index_path.name + ".", dir=index_path.parent
+            )
+        except OSError:
+            connection = sqlite3.connect(":memory:", check_same_thread=False)
+            _create_schema(connection)
+            _fill_index(connection, _load_entries(json_path), stat)
+            database = cls(connection)
+            database.rebuilt = True
+            return database
+
+        os.close(fd)
+        try:
+            connection = sqlite3.connect(tmp_path)
+            _create_schema(connection)
+            _fill_index(connection, _load_entries(json_path), stat)
+            connection.close()
+            os.replace(tmp_path, index_path)
+        except BaseException:
+            os.unlink(tmp_path)
+            raise
+
+        connection = sqlite3.connect(
+            f"file:{index_path}?mode=ro", uri=True, check_same_thread=False
+        )
+        database = cls(connection, str(index_path))
+        database.rebuilt = True
+        return database
+
+    def getCompileCommands(self, filename: str) -> list:
+        """
+        Look up the compile commands of a file.
+
+        Args:
+            filename: Source file; relative paths are taken relative to the
+                current directory
+
+        Returns:
+            List of CompileCommand (empty if the file is not in the database)
+        """
+        path = os.path.normpath(os.path.abspath(filename))
+        with self._lock:
+            rows = self._connection.execute(
+                "SELECT directory, arguments, command FROM commands "
+                "WHERE file = ? ORDER BY seq",
+                (path,),
+            ).fetchall()
+            if not rows:
+                # The database may name the file through a symlink
+                rows = self._connection.execute(
+                    "SELECT directory, arguments, command FROM commands "
+                    "WHERE real_file = ? ORDER BY file, seq",
+                    (os.path.realpath(path),),
+                ).fetchall()
+        return [
+            CompileCommand(
+                directory,
+                path,
+                json.loads(arguments) if arguments is not None else shlex.split(command),
+            )
+            for directory, arguments, command in rows
+        ]
+
+    def files(self) -> list:
+        """Return every source file in the database, sorted."""
+        with self._lock:
+            return [
+                row[0]
+                for row in self._connection.execute(
+                    "SELECT DISTINCT file FROM commands ORDER BY file"
+                )
+            ]
+
+    def close(self) -> None:
+        with self._lock:
+            self._connection.close()
@@ -11,86 +11,99 @@ Usage with contained uv environment:
 Example:
     uv run eigen_auto_check.py ../examples.cpp
     uv run eigen_auto_check.py ../examples.cpp ../build
+    uv run eigen_auto_check.py ../examples.cpp ../build --checks=-expensive --timings
+    uv run eigen_auto_check.py --all ../build --jobs 8 --call-graph graph.json
+    uv run eigen_auto_check.py --all ../build --jobs 16 --pin=node
+    uv run eigen_auto_check.py --headers ../build
+    uv run eigen_auto_check.py ../examples.cpp ../build --watch
+    uv run eigen_auto_check.py ../examples.cpp ../build --stdin < edited.cpp
+    uv run eigen_auto_check.py --serve ../build --debounce 0.2
+    uv run eigen_auto_check.py ../examples.cpp --timings -- -std=c++20 -I/usr/include/eigen3
+    uv run eigen_auto_check.py --all ../build --cache-dir ~/.cache/eigen-auto-check
+    uv run eigen_auto_check.py cache stats --cache-dir ~/.cache/eigen-auto-check
+    uv run eigen_auto_check.py ../examples.cpp ../build --engine=clang-tidy \
+        --clang-tidy-plugin ../build/clang_tidy_plugin/EigenAutoCheckPlugin.so
 """
 
+import time
+
+# Taken before the other imports, so that "startup" in --timings includes them
+_IMPORT_START = time.perf_counter()
+
+import os
+import re
 import sys
 import argparse
+import json
+import threading
 from pathlib import Path
 import clang.cindex
 
+import compdb as compdb_index
+from affinity import (
+    PIN_MODES,
+    PlacementPool,
+    format_placement,
+    pin_current,
+    plan_placements,
+)
+from analysis_cache import (
+    CACHE_DIR_ENV,
+    DEFAULT_MAX_SIZE,
+    AnalysisCache,
+    make_key,
+    parse_size,
+)
+from call_graph import (
+    COLD_HOTNESS,
+    CallGraphCollector,
+    merge_call_graph,
+    propagate_hotness,
+    rank_issues,
+    write_call_graph,
+)
+from check_registry import (
+    Check,
+    FunctionCache,
+    available_checks,
+    register_check,
+    run_checks,
+    select_checks,
+)
+from eigen_types import (
+    get_source_range,
+    get_unqualified_type_name,
+    is_in_eigen_namespace,
+    strip_reference,
+)
+
 # Global verbose flag
 VERBOSE = False
 
+# Concepts that only accept plain storage types (include/eigen_auto/concepts.h);
+# declarations constrained with them are not analyzed.
+PLAIN_CONCEPTS = frozenset({"EigenPlain"})
 
-def strip_reference(type_obj: clang.cindex.Type) -> clang.cindex.Type:
-    """
-    Strip reference wrappers from a type.
-    Similar to std::remove_reference in C++.
+# Classification of canonical type spellings: (in Eigen namespace, allowed).
+# Canonical spellings are fully qualified, so the result only depends on the
+# spelling; shared by all threads of the in-process backend.
+_CLASSIFICATION_CACHE = {}
 
-    Args:
-        type_obj: The Type object to strip
+# Types that own (or, for TensorMap, directly address) their coefficients;
+# every other Eigen type is an unevaluated expression. The Tensor types come
+# from unsupported/Eigen/CXX11/Tensor.
+PLAIN_STORAGE_TYPES = (
+    "Eigen::Matrix",
+    "Eigen::Array",
+    "Eigen::Tensor",
+    "Eigen::TensorFixedSize",
+    "Eigen::TensorMap",
+)
+_PLAIN_STORAGE_PREFIXES = tuple(f"{name}<" for name in PLAIN_STORAGE_TYPES)
 
-    Returns:
-        The type after stripping references
-    """
-    stripped = type_obj
-
-    # For reference types, get the pointee (the type being referenced)
-    if (
-        stripped.kind == clang.cindex.TypeKind.LVALUEREFERENCE
-        or stripped.kind == clang.cindex.TypeKind.RVALUEREFERENCE
-    ):
-        stripped = stripped.get_pointee()
-
-    return stripped
-
-
-def get_unqualified_type_name(type_obj: clang.cindex.Type) -> str:
-    """
-    Get the type name with references and const qualifiers removed.
-    Similar to std::remove_cvref in C++.
-
-    Args:
-        type_obj: The Type object
-
-    Returns:
-        The spelling of the type without const and references
-    """
-    stripped = strip_reference(type_obj)
-    type_spelling = stripped.spelling
-
-    # Remove 'const ' prefix if present
-    return type_spelling.removeprefix("const ")
-
-
-def is_in_eigen_namespace(type_obj: clang.cindex.Type) -> bool:
-    """
-    Check if a type is declared within the Eigen namespace.
-
-    Args:
-        type_obj: The Type object to check
-
-    Returns:
-        True if the type is in the Eigen namespace, False otherwise
-    """
-    stripped_type = strip_reference(type_obj)
-    decl = stripped_type.get_declaration()
-    if not decl or decl.kind == clang.cindex.CursorKind.NO_DECL_FOUND:
-        return False
-
-    # Walk up the semantic parent chain looking for a namespace named "Eigen"
-    parent = decl.semantic_parent
-    while parent:
-        if (
-            parent.kind == clang.cindex.CursorKind.NAMESPACE
-            and parent.spelling == "Eigen"
-        ):
-            return True
-        if parent.kind == clang.cindex.CursorKind.TRANSLATION_UNIT:
-            break
-        parent = parent.semantic_parent
-
-    return False
+# With --pin, threads of the in-process backend share one classification cache
+# per NUMA node instead, first touched by a thread running on that node.
+_NODE_CLASSIFICATION_CACHES = {}
 
 
 def is_allowed_auto_type(canonical_type: clang.cindex.Type) -> bool:
@@ -108,14 +121,13 @@ def is_allowed_auto_type(canonical_type: clang.cindex.Type) -> bool:
     if VERBOSE:
         print(f"[DEBUG] Checking allowlist for type: '{type_spelling}'")
 
-    # Allowlist: Only Eigen::Matrix and Eigen::Array are plain storage types
-    # All other Eigen types (Product, CwiseBinaryOp, Transpose, etc.) are expression templates
+    # Allowlist: Matrix, Array and the Tensor storage types are plain
+    # All other Eigen types (Product, CwiseBinaryOp, TensorContractionOp, etc.)
+    # are expression templates
 
-    if type_spelling.startswith("Eigen::Matrix<") or type_spelling.startswith(
-        "Eigen::Array<"
-    ):
+    if type_spelling.startswith(_PLAIN_STORAGE_PREFIXES):
         if VERBOSE:
-            print("[DEBUG] -> ALLOWED (plain Matrix/Array storage type)")
+            print("[DEBUG] -> ALLOWED (plain storage type)")
         return True
 
     if VERBOSE:
@@ -123,24 +135,81 @@ def is_allowed_auto_type(canonical_type: clang.cindex.Type) -> bool:
     return False
 
 
-def get_source_range(lines: list, start_line: int, end_line: int) -> str:
+def _condition_end(if_stmt) -> int:
+    """Offset just past the parenthesized condition of an if statement."""
+    depth = 0
+    for token in if_stmt.get_tokens():
+        if token.spelling == "(":
+            depth += 1
+        elif token.spelling == ")":
+            depth -= 1
+            if depth == 0:
+                return token.extent.end.offset
+    return if_stmt.extent.start.offset
+
+
+def _is_branch(node, index: int, child, children: list) -> bool:
+    """Check whether child is only executed on some paths through node."""
+    kind = node.kind
+    if kind == clang.cindex.CursorKind.IF_STMT:
+        return child.extent.start.offset >= _condition_end(node)
+    if kind == clang.cindex.CursorKind.CONDITIONAL_OPERATOR:
+        return index > 0
+    if kind == clang.cindex.CursorKind.SWITCH_STMT:
+        return index == len(children) - 1
+    if kind == clang.cindex.CursorKind.BINARY_OPERATOR and index == 1:
+        # The Python bindings do not expose the opcode: take the first token
+        # after the left operand
+        lhs_end = children[0].extent.end.offset
+        for token in node.get_tokens():
+            if token.extent.start.offset >= lhs_end:
+                return token.spelling in ("&&", "||")
+    return False
+
+
+def is_used_conditionally(cursor) -> bool:
     """
-    Get a range of source lines from pre-loaded file content.
+    Check whether a local variable is read, but only on some paths.
+
+    A use is conditional if it lies in a branch of an if, switch, ?: or of the
+    right operand of && / || that starts after the declaration; branches
+    enclosing the declaration itself do not count.
 
     Args:
-        lines: List of lines from the source file
-        start_line: Starting line number (1-indexed)
-        end_line: Ending line number (1-indexed)
+        cursor: VAR_DECL cursor of a local variable
 
     Returns:
-        Joined string of the line range
+        True if the variable has uses and every one of them is conditional
     """
-    if 1 <= start_line <= len(lines) and 1 <= end_line <= len(lines):
-        # Get all lines in the range
-        source_lines = [lines[i - 1].rstrip() for i in range(start_line, end_line + 1)]
-        # Join with spaces to make it a single line for display
-        return " ".join(line.strip() for line in source_lines if line.strip())
-    return "?"
+    function = cursor.semantic_parent
+    if function is None or not function.is_definition():
+        return False
+    decl_end = cursor.extent.end.offset
+    name = cursor.spelling
+    conditional_uses = 0
+    unconditional_uses = 0
+
+    def walk(node, conditional: bool) -> None:
+        nonlocal conditional_uses, unconditional_uses
+        children = list(node.get_children())
+        after_decl = node.extent.start.offset > decl_end
+        for index, child in enumerate(children):
+            child_conditional = conditional or (
+                after_decl and _is_branch(node, index, child, children)
+            )
+            if (
+                child.kind == clang.cindex.CursorKind.DECL_REF_EXPR
+                and child.spelling == name
+                and child.referenced == cursor
+            ):
+                if child_conditional:
+                    conditional_uses += 1
+                else:
+                    unconditional_uses += 1
+            walk(child, child_conditional)
+
+    walk(function, False)
+    return conditional_uses > 0 and unconditional_uses == 0
 
 
 def analyze_var_decl(cursor, filename: str, source_lines: list) -> list:
@@ -167,20 +236,31 @@ def analyze_var_decl(cursor, filename: str, source_lines: list) -> list:
 
     uses_auto = False
     uses_decltype_auto = False
+    constraint = None
 
     # Look for auto or decltype(auto) in the declaration
     for i, token in enumerate(tokens):
         if token.spelling == "auto":
             uses_auto = True
+            constraint_index = i - 1
             # Check for decltype(auto)
             if i > 0 and tokens[i - 1].spelling == "(":
                 if i > 1 and tokens[i - 2].spelling == "decltype":
                     uses_decltype_auto = True
+                    constraint_index = i - 3
+            if constraint_index >= 0:
+                constraint = tokens[constraint_index].spelling
             break
 
     if not uses_auto:
         return issues
 
+    # The compiler already rejects expression templates for these
+    if constraint in PLAIN_CONCEPTS:
+        if VERBOSE:
+            print(f"[DEBUG] Variable '{cursor.spelling}': constrained by {constraint}, skipped")
+        return issues
+
     # Get the actual deduced type
     var_type = cursor.type
     type_name = var_type.spelling
@@ -194,12 +274,21 @@ def analyze_var_decl(cursor, filename: str, source_lines: list) -> list:
             f"[DEBUG] Variable '{cursor.spelling}': type='{type_name}', canonical='{canonical_name}'"
         )
 
+    classification_cache = getattr(
+        _THREAD_STATE, "classification_cache", _CLASSIFICATION_CACHE
+    )
+    classification = classification_cache.get(canonical_name)
+    if classification is None:
+        in_eigen = is_in_eigen_namespace(canonical_type)
+        classification = (in_eigen, in_eigen and is_allowed_auto_type(canonical_type))
+        classification_cache[canonical_name] = classification
+
     # Only check Eigen types
-    if not is_in_eigen_namespace(canonical_type):
+    if not classification[0]:
         return issues
 
     # Check if the canonical type is on the allowlist
-    is_allowed = is_allowed_auto_type(canonical_type)
+    is_allowed = classification[1]
 
     if not is_allowed:
         # This is an Eigen type that's NOT on the allowlist
@@ -211,31 +300,259 @@ def analyze_var_decl(cursor, filename: str, source_lines: list) -> list:
         # Get the complete source range (handles multi-line expressions)
         source_text = get_source_range(source_lines, location.line, end_location.line)
 
-        issues.append(
+        issue = {
+            "file": filename,
+            "line": location.line,
+            "column": location.column,
+            "variable": cursor.spelling,
+            "type": canonical_name,
+            "type_as_written": type_name,
+            "auto_kind": auto_kind,
+            "source": source_text,
+        }
+        # .eval() would compute the result even on paths that never read it
+        if is_used_conditionally(cursor):
+            issue["suggestion"] = (
+                f"'{cursor.spelling}' is only read on some paths: "
+                "eigen_auto::lazy_eval (include/eigen_auto/lazy_eval.h) "
+                "evaluates it once, on first access"
+            )
+        issues.append(issue)
+
+    return issues
+
+
+@register_check
+class EigenAutoCheck(Check):
+    """auto/decltype(auto) variables deducing an Eigen expression template."""
+
+    name = "eigen-auto"
+    description = "auto/decltype(auto) capturing an Eigen expression template"
+    cursor_kinds = frozenset({clang.cindex.CursorKind.VAR_DECL})
+
+    def visit(self, cursor, context):
+        return analyze_var_decl(cursor, context.filename, context.source_lines)
+
+
+# Contractions are only reported when their operands are all fixed-size and
+# they take at least this many FLOPs; below it a thread pool costs more than it
+# saves, and for dynamic sizes the cost is unknown until run time
+TENSOR_DEVICE_MIN_FLOPS = 1 << 20
+
+# Calls that evaluate a tensor expression into plain storage on the default
+# device: assignments and constructors of the plain tensor types
+_TENSOR_EVALUATING_CALLS = frozenset(
+    {"operator=", "operator+=", "operator-=", "Tensor", "TensorFixedSize"}
+)
+
+_SIZES_RE = re.compile(r"Eigen::Sizes<([\d, ]*)>")
+
+# Number of contracted index pairs: std::array<Eigen::IndexPair<...>, N>
+_INDEX_PAIRS_RE = re.compile(r"IndexPair<[^<>]*>, (\d+)>$")
+
+
+def _eigen_record_name(type_obj: clang.cindex.Type) -> str:
+    """Name of the Eigen class template of a type, or "" for other types."""
+    decl = type_obj.get_declaration()
+    if decl.kind == clang.cindex.CursorKind.NO_DECL_FOUND:
+        return ""
+    return decl.spelling if is_in_eigen_namespace(type_obj) else ""
+
+
+def _template_argument_types(type_obj: clang.cindex.Type) -> list:
+    """Canonical type arguments of a class template specialization."""
+    arguments = []
+    for i in range(max(type_obj.get_num_template_arguments(), 0)):
+        argument = type_obj.get_template_argument_type(i)
+        if argument.kind != clang.cindex.TypeKind.INVALID:
+            arguments.append(argument.get_canonical())
+    return arguments
+
+
+def _product(values) -> int:
+    result = 1
+    for value in values:
+        result *= value
+    return result
+
+
+def find_tensor_contractions(type_obj: clang.cindex.Type) -> list:
+    """
+    Find the TensorContractionOp types nested in a tensor expression type.
+
+    Returns:
+        List of canonical contraction types, outermost first
+    """
+    type_obj = strip_reference(type_obj).get_canonical()
+    name = _eigen_record_name(type_obj)
+    if not name.startswith("Tensor"):
+        return []
+    found = [type_obj] if name == "TensorContractionOp" else []
+    for argument in _template_argument_types(type_obj):
+        found.extend(find_tensor_contractions(argument))
+    return found
+
+
+def tensor_extents(type_obj: clang.cindex.Type):
+    """
+    Extents of the largest tensor a tensor expression reads.
+
+    Returns:
+        List of extents of the TensorFixedSize with the most coefficients
+        ([] if the expression reads none), or None if any tensor in it has a
+        size only known at run time
+    """
+    type_obj = strip_reference(type_obj).get_canonical()
+    name = _eigen_record_name(type_obj)
+    if name == "Tensor":
+        return None
+    if name == "TensorFixedSize":
+        match = _SIZES_RE.search(type_obj.spelling)
+        if match is None:
+            return None
+        return [int(extent) for extent in match.group(1).split(",") if extent.strip()]
+    largest = []
+    if name.startswith("Tensor"):
+        for argument in _template_argument_types(type_obj):
+            extents = tensor_extents(argument)
+            if extents is None:
+                return None
+            if _product(extents) > _product(largest):
+                largest = extents
+    return largest
+
+
+def contraction_flops(contraction: clang.cindex.Type):
+    """
+    Lower bound of the FLOPs of a contraction of fixed-size operands.
+
+    A contraction of N index pairs with contracted size K costs
+    2 * |lhs| * |rhs| / K; K is at most the product of the N largest extents
+    of either operand, which gives the bound.
+
+    Returns:
+        The bound, or None if an operand's size or the number of contracted
+        index pairs is not known at compile time
+    """
+    arguments = _template_argument_types(contraction)
+    if len(arguments) < 3:
+        return None
+    match = _INDEX_PAIRS_RE.search(arguments[0].spelling.removeprefix("const "))
+    if match is None:
+        return None
+    pairs = int(match.group(1))
+    operands = [tensor_extents(operand) for operand in arguments[1:3]]
+    if None in operands or not all(operands):
+        return None
+    contracted = min(
+        _product(sorted(extents)[len(extents) - pairs :]) for extents in operands
+    )
+    if contracted == 0:
+        return 0
+    return 2 * _product(operands[0]) * _product(operands[1]) // contracted
+
+
+def analyze_tensor_evaluation(cursor, context) -> list:
+    """
+    Find tensor contractions evaluated on the default device.
+
+    `result = a.contract(b, dims)` (or a constructor taking the contraction)
+    evaluates on Eigen::DefaultDevice, i.e. single-threaded. Large
+    contractions should be evaluated with `result.device(pool_device) = ...`
+    on an Eigen::ThreadPoolDevice instead, which assigns through a
+    TensorDevice and is therefore not matched here. Only contractions known
+    at compile time to take at least TENSOR_DEVICE_MIN_FLOPS are reported.
+
+    Returns:
+        List with at most one issue dict
+    """
+    if cursor.spelling not in _TENSOR_EVALUATING_CALLS:
+        return []
+    result_type = cursor.type.get_canonical()
+    if _eigen_record_name(strip_reference(result_type)) not in (
+        "Tensor",
+        "TensorFixedSize",
+        "TensorMap",
+    ):
+        return []
+    # Operator calls list the assigned object as their first argument
+    is_assignment = cursor.spelling.startswith("operator")
+    arguments = list(cursor.get_arguments())
+    if len(arguments) != (2 if is_assignment else 1):
+        return []
+
+    for contraction in find_tensor_contractions(arguments[-1].type):
+        flops = contraction_flops(contraction)
+        if flops is None or flops < TENSOR_DEVICE_MIN_FLOPS:
+            continue
+
+        # Name the destination: the declared variable or the assigned operand
+        target = None
+        if is_assignment:
+            target = arguments[0].spelling or None
+        else:
+            for ancestor in reversed(context.ancestors):
+                if ancestor.kind == clang.cindex.CursorKind.VAR_DECL:
+                    target = ancestor.spelling
+                    break
+                if ancestor.kind != clang.cindex.CursorKind.UNEXPOSED_EXPR:
+                    break
+        destination = f"'{target}'" if target else "the result"
+        location = cursor.extent.start
+        return [
             {
-                "file": filename,
+                "file": context.filename,
                 "line": location.line,
                 "column": location.column,
-                "variable": cursor.spelling,
-                "type": canonical_name,
-                "type_as_written": type_name,
-                "auto_kind": auto_kind,
-                "source": source_text,
+                "variable": target or "",
+                "type": contraction.spelling.removeprefix("const "),
+                "message": (
+                    f"tensor contraction of at least {flops:,} FLOPs is evaluated "
+                    f"into {destination} "
+                    "on the default single-threaded device"
+                ),
+                "source": get_source_range(
+                    context.source_lines, location.line, cursor.extent.end.line
+                ),
+                "suggestion": (
+                    f"evaluate with {target or 'result'}.device(pool_device) = ...; "
+                    "where pool_device is an Eigen::ThreadPoolDevice "
+                    "(requires EIGEN_USE_THREADS)"
+                ),
             }
-        )
+        ]
+    return []
 
-    return issues
 
+@register_check
+class EigenTensorDeviceCheck(Check):
+    """Large tensor contractions evaluated on the default device."""
+
+    name = "eigen-tensor-device"
+    description = "Large tensor contraction evaluated on the single-threaded default device"
+    cursor_kinds = frozenset({clang.cindex.CursorKind.CALL_EXPR})
 
-def load_compilation_database(build_dir: str):
+    def visit(self, cursor, context):
+        return analyze_tensor_evaluation(cursor, context)
+
+
+def load_compilation_database(
+    build_dir: str, timings: dict = None, only_file: str = None
+):
     """
     Load compilation database from build directory.
 
+    The database is served from an index cached next to the JSON (see
+    compdb.py), which is rebuilt only when compile_commands.json changes.
+
     Args:
         build_dir: Directory containing compile_commands.json
+        timings: Optional dict accumulating the load time under "compdb-load"
+        only_file: For single-file runs: if the index is not current, load
+            only this file's entries instead of building it
 
     Returns:
-        CompilationDatabase object
+        compdb.CompilationDatabase object
     """
     build_path = Path(build_dir).resolve()
     compdb_path = build_path / "compile_commands.json"
@@ -247,7 +564,23 @@ def load_compilation_database(build_dir: str):
     if not compdb_path.exists():
         raise FileNotFoundError(f"compile_commands.json not found at {compdb_path}")
 
-    return clang.cindex.CompilationDatabase.fromDirectory(str(build_path))
+    load_start = time.perf_counter()
+    database = compdb_index.CompilationDatabase.from_directory(
+        str(build_path), only_file
+    )
+    if timings is not None:
+        timings["compdb-load"] = timings.get("compdb-load", 0.0) + (
+            time.perf_counter() - load_start
+        )
+
+    if VERBOSE:
+        if database.partial:
+            print(f"[DEBUG] Loaded only the entries of {only_file}")
+        else:
+            state = "rebuilt" if database.rebuilt else "reused"
+            print(f"[DEBUG] compile_commands.json index {state}: {database.index_path}")
+
+    return database
 
 
 def get_compile_args(compdb, filename: str) -> list:
@@ -273,7 +606,7 @@ def get_compile_args(compdb, filename: str) -> list:
 
     # Extract compiler flags from compilation database
     cmd_args = []
-    for cmd in compdb.getCompileCommands(filename):
+    for cmd in commands:
         cmd_args.extend(cmd.arguments)
 
     # Skip the compiler executable name and filter out problematic flags
@@ -304,26 +637,281 @@ def get_compile_args(compdb, filename: str) -> list:
     return filtered_args
 
 
-def check_file(filename: str, compdb) -> list:
-    """Check a single C++ file for auto/Eigen issues."""
-    issues = []
+def check_file(
+    filename: str,
+    compdb,
+    checks: list = None,
+    timings: dict = None,
+    index: clang.cindex.Index = None,
+    compile_args: list = None,
+    cache: AnalysisCache = None,
+    dependencies: list = None,
+    unsaved_files: dict = None,
+) -> list:
+    """
+    Check a single C++ file for auto/Eigen issues.
 
-    # Read source file once for later use
-    with open(filename, "r", encoding="utf-8") as f:
-        source_lines = f.readlines()
+    Args:
+        filename: Absolute path of the source file
+        compdb: CompilationDatabase object (unused if compile_args is given)
+        checks: Check instances to run (default: all registered checks)
+        timings: Optional dict accumulating seconds per phase and per check,
+            and counting result cache outcomes under "cache-hits",
+            "cache-misses" and "cache-writes"
+        index: Index to parse with (default: a new one per call)
+        compile_args: Compiler arguments, bypassing the compilation database
+        cache: Optional AnalysisCache; a hit skips parsing and analysis
+        dependencies: Optional list extended with every file the TU
+            included, e.g. for a depfile
+        unsaved_files: Optional dict mapping absolute paths to editor buffer
+            contents, used instead of the files on disk (including filename)
+
+    Returns:
+        List of issue dicts
+    """
+    if checks is None:
+        checks = select_checks("*")
+
+    # Read source file once for later use; snippets come from these lines
+    source_lines = read_source_lines(filename, unsaved_files)
 
     # Initialize libclang
-    index = clang.cindex.Index.create()
+    if index is None:
+        index = clang.cindex.Index.create()
 
     # Get compilation arguments for this file
-    args = get_compile_args(compdb, filename)
+    if compile_args is not None:
+        args = compile_args
+    else:
+        args = get_compile_args(compdb, filename)
+
+    cache_key = None
+    if cache is not None:
+        cache_key = result_cache_key(
+            filename, "".join(source_lines), args, checks, unsaved_files
+        )
+        cached = load_cached_result(cache, cache_key, checks, dependencies)
+        count_cache_event(timings, "cache-hits" if cached is not None else "cache-misses")
+        if cached is not None:
+            return cached
+
+    issues, translation_unit = analyze_source(
+        filename, source_lines, args, checks, timings, index, unsaved_files
+    )
+    if dependencies is not None:
+        dependencies.extend(path for path, _, _ in include_dependencies(translation_unit))
+
+    if cache is not None:
+        store_cached_result(cache, cache_key, translation_unit, issues, checks)
+        count_cache_event(timings, "cache-writes")
+
+    return issues
+
+
+def analyze_source(
+    filename: str,
+    source_lines: list,
+    args: list,
+    checks: list,
+    timings: dict,
+    index: clang.cindex.Index,
+    unsaved_files: dict = None,
+) -> tuple:
+    """
+    Parse a file and run the checks over its AST.
 
-    # Parse the file
+    Returns:
+        Tuple (list of issue dicts, translation unit)
+    """
     if VERBOSE:
         print(f"[DEBUG] Parsing {filename}...")
 
-    translation_unit = index.parse(filename, args=args)
+    parse_start = time.perf_counter()
+    translation_unit = index.parse(
+        filename,
+        args=args,
+        unsaved_files=list(unsaved_files.items()) if unsaved_files else None,
+    )
+    if timings is not None:
+        timings["parse"] = timings.get("parse", 0.0) + (
+            time.perf_counter() - parse_start
+        )
+
+    report_diagnostics(translation_unit)
+
+    # Walk the AST once, dispatching nodes to every enabled check
+    issues = run_checks(translation_unit, filename, source_lines, checks, timings)
+    return issues, translation_unit
+
+
+# Hash of the analysis code, part of every result cache key
+_CHECKER_VERSION = None
+
+
+def checker_version() -> str:
+    """Hash the checker's own sources so that code changes invalidate results."""
+    global _CHECKER_VERSION
+    if _CHECKER_VERSION is None:
+        here = Path(__file__).resolve().parent
+        parts = []
+        # Every module next to the checker, like the CMake integration's DEPENDS
+        for path in sorted(here.glob("*.py")):
+            parts.append(path.name)
+            parts.append(path.read_bytes())
+        import importlib.metadata
+
+        try:
+            parts.append(importlib.metadata.version("libclang"))
+        except importlib.metadata.PackageNotFoundError:
+            parts.append(clang.cindex.conf.get_filename())
+        _CHECKER_VERSION = make_key(*parts)
+    return _CHECKER_VERSION
+
+
+def result_cache_key(
+    filename: str, source: str, args: list, checks: list, unsaved_files: dict = None
+) -> str:
+    """Key of a file's analysis results: code, inputs, flags and checks."""
+    # Unsaved headers are not covered by the on-disk dependency check
+    overrides = sorted(
+        (path, content)
+        for path, content in (unsaved_files or {}).items()
+        if path != filename
+    )
+    return make_key(
+        checker_version(),
+        filename,
+        source,
+        "\0".join(args),
+        "\0".join(sorted(check.name for check in checks)),
+        *(f"{path}\0{content}" for path, content in overrides),
+    )
+
+
+def load_cached_result(
+    cache: AnalysisCache, key: str, checks: list, dependencies: list = None
+):
+    """
+    Return cached issues for a key, restoring per-check state.
+
+    The entry is only valid if none of the headers the TU included changed
+    since it was written (compared by mtime and size).
+
+    Args:
+        dependencies: Optional list extended with the entry's included files
+            on a hit
+
+    Returns:
+        List of issue dicts, or None on a miss
+    """
+    entry = cache.get_json(key)
+    if entry is None:
+        return None
+    for path, mtime_ns, size in entry["dependencies"]:
+        try:
+            stat = os.stat(path)
+        except OSError:
+            return None
+        if stat.st_mtime_ns != mtime_ns or stat.st_size != size:
+            return None
+    for check in checks:
+        check.import_state(entry["state"].get(check.name))
+    if dependencies is not None:
+        dependencies.extend(path for path, _, _ in entry["dependencies"])
+    return entry["issues"]
+
+
+def include_dependencies(translation_unit) -> list:
+    """
+    List the files a translation unit included.
+
+    Returns:
+        List of (path, mtime_ns, size) tuples, without duplicates
+    """
+    dependencies = []
+    seen = set()
+    for inclusion in translation_unit.get_includes():
+        path = inclusion.include.name
+        if path in seen:
+            continue
+        seen.add(path)
+        try:
+            stat = os.stat(path)
+        except OSError:
+            continue
+        dependencies.append((path, stat.st_mtime_ns, stat.st_size))
+    return dependencies
+
+
+def store_cached_result(
+    cache: AnalysisCache, key: str, translation_unit, issues: list, checks: list
+) -> None:
+    """Write a file's issues, check state and header dependencies."""
+    cache.put_json(
+        key,
+        {
+            "dependencies": include_dependencies(translation_unit),
+            "issues": issues,
+            "state": {check.name: check.export_state() for check in checks},
+        },
+    )
+
+
+def _depfile_escape(path: str) -> str:
+    """Escape a path for a Make-syntax depfile."""
+    for char, escaped in ((" ", "\\ "), ("#", "\\#"), ("$", "$$")):
+        path = path.replace(char, escaped)
+    return path
+
 
+def write_stamp(stamp: str, depfile: str, source: str, dependencies: list) -> None:
+    """
+    Write the stamp file of a build-integrated check, and its depfile.
+
+    The depfile uses Make syntax, which Ninja also reads, and lists the source
+    and every file it included as prerequisites of the stamp, so the build
+    tool re-runs the check only when one of them changes.
+    """
+    os.makedirs(os.path.dirname(os.path.abspath(stamp)), exist_ok=True)
+    if depfile:
+        prerequisites = [source] + [path for path in dependencies if path != source]
+        with open(depfile, "w", encoding="utf-8") as f:
+            f.write(_depfile_escape(stamp) + ":")
+            for path in prerequisites:
+                f.write(" \\\n  " + _depfile_escape(path))
+            f.write("\n")
+    with open(stamp, "w", encoding="utf-8") as f:
+        f.write(f"{source}\n")
+
+
+def count_cache_event(timings: dict, event: str) -> None:
+    if timings is not None:
+        timings[event] = timings.get(event, 0) + 1
+
+
+def open_cache(args):
+    """Create the AnalysisCache selected on the command line, if any."""
+    cache_dir = args.cache_dir or os.environ.get(CACHE_DIR_ENV)
+    if not cache_dir or args.no_cache:
+        return None
+    return AnalysisCache(cache_dir, parse_size(args.cache_max_size))
+
+
+def finish_cache(cache: AnalysisCache, timings: dict) -> None:
+    """Record this run's cache statistics, evict if needed, print the hit rate."""
+    if cache is None:
+        return
+    cache.hits = int(timings.get("cache-hits", 0))
+    cache.misses = int(timings.get("cache-misses", 0))
+    cache.writes = int(timings.get("cache-writes", 0))
+    cache.record_run()
+    if cache.writes:
+        cache.prune()
+    print(cache.summary())
+
+
+def report_diagnostics(translation_unit) -> None:
+    """Print parse errors of a translation unit in verbose mode."""
     # Check for parse errors
     if VERBOSE:
         print(f"[DEBUG] Checking diagnostics...")
@@ -350,59 +938,1201 @@ def check_file(filename: str, compdb) -> list:
         else:
             print("[DEBUG] ✓ Parse successful")
 
-    # Walk the AST
-    def visit_node(cursor):
-        # Analyze this node
-        issues.extend(analyze_var_decl(cursor, filename, source_lines))
 
-        # Recurse into children
-        for child in cursor.get_children():
-            visit_node(child)
+def read_source_lines(filename: str, unsaved_files: dict = None) -> list:
+    """Lines of a file, from its unsaved buffer if there is one."""
+    if unsaved_files and filename in unsaved_files:
+        return unsaved_files[filename].splitlines(keepends=True)
+    with open(filename, "r", encoding="utf-8") as f:
+        return f.readlines()
 
-    visit_node(translation_unit.cursor)
 
-    return issues
+def read_unsaved_files(source) -> dict:
+    """
+    Read path -> content overrides from a JSON object.
+
+    Args:
+        source: Path of a JSON file, or "-" for stdin
+
+    Returns:
+        Dict mapping absolute paths to file contents
+    """
+    if source == "-":
+        overrides = json.load(sys.stdin)
+    else:
+        with open(source, "r", encoding="utf-8") as f:
+            overrides = json.load(f)
+    if not isinstance(overrides, dict):
+        raise ValueError("unsaved files must be a JSON object of path -> content")
+    return {str(Path(path).resolve()): content for path, content in overrides.items()}
+
+
+class EditorSession:
+    """
+    Keeps one translation unit and FunctionCache per file for --serve.
+
+    Reparsing with a precompiled preamble and reusing unchanged functions
+    makes a re-check after an edit much cheaper than a cold check_file().
+    """
+
+    def __init__(self, compdb, compile_args: list, checks: list):
+        self.compdb = compdb
+        self.compile_args = compile_args
+        self.checks = checks
+        self.index = clang.cindex.Index.create()
+        self.units = {}
+
+    def check(self, filename: str, unsaved_files: dict) -> list:
+        """Check a file with the given buffers; returns the issues."""
+        unsaved = list(unsaved_files.items()) or None
+        if filename in self.units:
+            translation_unit, function_cache = self.units[filename]
+            translation_unit.reparse(unsaved_files=unsaved)
+        else:
+            args = self.compile_args
+            if args is None:
+                args = get_compile_args(self.compdb, filename)
+            translation_unit = self.index.parse(
+                filename,
+                args=args,
+                unsaved_files=unsaved,
+                options=clang.cindex.TranslationUnit.PARSE_PRECOMPILED_PREAMBLE,
+            )
+            function_cache = FunctionCache()
+            self.units[filename] = (translation_unit, function_cache)
+        report_diagnostics(translation_unit)
+        return run_checks(
+            translation_unit,
+            filename,
+            read_source_lines(filename, unsaved_files),
+            self.checks,
+            None,
+            function_cache,
+        )
+
+
+def serve(compdb, compile_args: list, checks: list, debounce: float) -> None:
+    """
+    Answer check requests from an editor, one JSON object per line.
+
+    A request on stdin is {"id": ..., "file": path, "content": buffer,
+    "unsaved": {path: buffer}}; "content" and "unsaved" are optional. Each
+    answer on stdout is {"id", "file", "issues", "elapsed_s"} or {"id",
+    "file", "error"}. A file is checked once no newer request for it has
+    arrived for `debounce` seconds, so that typing bursts cost one check;
+    superseded requests are answered with "superseded": true and no issues.
+
+    Args:
+        compdb: CompilationDatabase object (unused if compile_args is given)
+        compile_args: Compiler arguments for every file, or None
+        checks: Check instances to run
+        debounce: Quiet period per file in seconds
+    """
+    import select
+
+    session = EditorSession(compdb, compile_args, checks)
+    stdin_fd = sys.stdin.fileno()
+    buffer = b""
+    pending = {}  # file -> (request, deadline)
+    at_eof = False
+
+    def answer(response: dict) -> None:
+        sys.stdout.write(json.dumps(response) + "\n")
+        sys.stdout.flush()
+
+    while not at_eof or pending:
+        now = time.monotonic()
+        timeout = None
+        if pending:
+            timeout = max(0.0, min(deadline for _, deadline in pending.values()) - now)
+        if at_eof:
+            time.sleep(timeout)
+        elif select.select([stdin_fd], [], [], timeout)[0]:
+            chunk = os.read(stdin_fd, 1 << 16)
+            at_eof = not chunk
+            buffer += chunk
+            *lines, buffer = buffer.split(b"\n")
+            for line in lines:
+                if not line.strip():
+                    continue
+                try:
+                    request = json.loads(line)
+                    filename = str(Path(request["file"]).resolve())
+                except (ValueError, KeyError, TypeError) as e:
+                    answer({"error": f"invalid request: {e}"})
+                    continue
+                if filename in pending:
+                    answer({"id": pending[filename][0].get("id"), "file": filename,
+                            "superseded": True, "issues": []})
+                pending[filename] = (request, time.monotonic() + debounce)
+
+        now = time.monotonic()
+        for filename, (request, deadline) in list(pending.items()):
+            if deadline > now:
+                continue
+            del pending[filename]
+            unsaved_files = {
+                str(Path(path).resolve()): content
+                for path, content in request.get("unsaved", {}).items()
+            }
+            if "content" in request:
+                unsaved_files[filename] = request["content"]
+            start = time.perf_counter()
+            try:
+                issues = session.check(filename, unsaved_files)
+            except (ValueError, OSError, clang.cindex.TranslationUnitLoadError) as e:
+                answer({"id": request.get("id"), "file": filename, "error": str(e)})
+                continue
+            answer(
+                {
+                    "id": request.get("id"),
+                    "file": filename,
+                    "issues": issues,
+                    "elapsed_s": time.perf_counter() - start,
+                }
+            )
+
+
+def watch_file(filename: str, compdb, checks: list, interval: float, timings: bool):
+    """
+    Re-check a file every time it changes on disk, until interrupted.
+
+    The translation unit is kept alive and reparsed with a precompiled
+    preamble, and a FunctionCache reuses the findings of every function whose
+    fingerprint did not change, so only edited functions are re-analyzed.
+
+    Args:
+        filename: Absolute path of the source file
+        compdb: CompilationDatabase object
+        checks: Check instances to run
+        interval: Polling interval in seconds
+        timings: Whether to print per-run timings
+    """
+    index = clang.cindex.Index.create()
+    args = get_compile_args(compdb, filename)
+    function_cache = FunctionCache()
+    translation_unit = None
+    last_mtime = None
+
+    while True:
+        try:
+            mtime = os.stat(filename).st_mtime_ns
+        except FileNotFoundError:
+            mtime = None
+        if mtime is not None and mtime != last_mtime:
+            last_mtime = mtime
+            run_timings = {}
+            with open(filename, "r", encoding="utf-8") as f:
+                source_lines = f.readlines()
+
+            parse_start = time.perf_counter()
+            if translation_unit is None:
+                translation_unit = index.parse(
+                    filename,
+                    args=args,
+                    options=clang.cindex.TranslationUnit.PARSE_PRECOMPILED_PREAMBLE,
+                )
+            else:
+                translation_unit.reparse()
+            run_timings["parse"] = time.perf_counter() - parse_start
+            report_diagnostics(translation_unit)
+
+            hits, misses = function_cache.hits, function_cache.misses
+            issues = run_checks(
+                translation_unit,
+                filename,
+                source_lines,
+                checks,
+                run_timings,
+                function_cache,
+            )
+
+            print(f"\n--- {time.strftime('%H:%M:%S')} {filename}")
+            if timings:
+                print_timings(run_timings, checks, issues)
+                print(
+                    f"  reused {function_cache.hits - hits} of "
+                    f"{function_cache.hits - hits + function_cache.misses - misses}"
+                    " function(s)",
+                    file=sys.stderr,
+                )
+            report_issues(issues)
+            sys.stdout.flush()
+
+        time.sleep(interval)
+
+
+def list_project_files(compdb) -> list:
+    """
+    List every source file in the compilation database.
+
+    Args:
+        compdb: CompilationDatabase object
+
+    Returns:
+        Sorted list of absolute source file paths
+    """
+    return compdb.files()
+
+
+# Items in flight per analysis worker between two pipeline stages
+PIPELINE_QUEUE_PER_WORKER = 2
+
+
+class ProjectJob:
+    """One file moving through the project pipeline."""
+
+    __slots__ = ("filename", "source_lines", "args", "cache_key", "timings", "result")
+
+    def __init__(self, filename: str):
+        self.filename = filename
+        self.source_lines = None
+        self.args = None
+        self.cache_key = None
+        self.timings = {}
+        # (issues, call edges, timings) once the file has been analyzed
+        self.result = None
+
+
+def analyze_project_file(
+    filename: str,
+    source_lines: list,
+    args: list,
+    checks_spec: str,
+    index: clang.cindex.Index,
+    cache: AnalysisCache = None,
+    cache_key: str = None,
+) -> tuple:
+    """
+    Parse and analyze one file of a project run, collecting its call edges.
+
+    Returns:
+        Tuple (issues, call edges, timings) for the file
+    """
+    collector = CallGraphCollector()
+    checks = select_checks(checks_spec) + [collector]
+    timings = {}
+    issues, translation_unit = analyze_source(
+        filename, source_lines, args, checks, timings, index
+    )
+    if cache is not None:
+        store_cached_result(cache, cache_key, translation_unit, issues, checks)
+        count_cache_event(timings, "cache-writes")
+    return issues, collector.edges, timings
+
+
+# Per-process Index and result cache for the process backend
+_WORKER_INDEX = None
+_WORKER_CACHE = None
+
+
+def _init_project_worker(
+    verbose: bool,
+    cache_dir: str = None,
+    cache_max_size: int = None,
+    placements=None,
+) -> None:
+    """Pin the worker process, then create its Index and cache handle once."""
+    global _WORKER_INDEX, _WORKER_CACHE, VERBOSE
+    VERBOSE = verbose
+    if placements is not None:
+        import queue
+
+        try:
+            placement = placements.get(timeout=1.0)
+        except queue.Empty:
+            # A replacement for a crashed worker; the plan is used up
+            placement = None
+        if placement is not None:
+            _pin_worker(placement, f"process {os.getpid()}")
+    # Allocated after pinning, so that its memory is local to the node
+    _WORKER_INDEX = clang.cindex.Index.create()
+    if cache_dir is not None:
+        _WORKER_CACHE = AnalysisCache(cache_dir, cache_max_size)
+
+
+def _analyze_in_worker(
+    filename: str, source_lines: list, args: list, checks_spec: str, cache_key: str
+) -> tuple:
+    """Process backend counterpart of analyze_project_file()."""
+    return analyze_project_file(
+        filename,
+        source_lines,
+        args,
+        checks_spec,
+        _WORKER_INDEX,
+        _WORKER_CACHE,
+        cache_key,
+    )
+
+
+# One Index per analysis thread of the thread backend
+_THREAD_STATE = threading.local()
+
+
+def _pin_worker(placement, worker: str) -> bool:
+    """Pin the calling worker to its placement, warning if that fails."""
+    if not pin_current(placement):
+        print(f"Warning: could not pin {worker} to {format_placement(placement)}",
+              file=sys.stderr)
+        return False
+    if VERBOSE:
+        print(f"[DEBUG] Pinned {worker} to {format_placement(placement)}")
+    return True
+
+
+def check_project(
+    compdb,
+    files: list,
+    checks_spec: str,
+    jobs: int,
+    timings: dict,
+    backend: str = "threads",
+    cache: AnalysisCache = None,
+    pin: str = "none",
+) -> tuple:
+    """
+    Check every file of a project and rank the findings by hotness.
+
+    Files stream through a pipeline of stages connected by bounded queues:
+
+        enumerate -> prepare -> cache-probe -> analyze -> report
+
+    prepare reads the source, looks up its flags and hashes it into a cache
+    key, dropping files without compile commands; cache-probe answers files
+    from the result cache, which then bypass analyze; analyze parses and runs
+    the checks on `jobs` workers; report collects the results. Reading and
+    hashing overlap with parsing, and the bounded queues keep at most a few
+    files per worker in memory at once.
+
+    Each TU contributes call edges that are merged into a project call graph;
+    hotness is then propagated through it so that findings in functions called
+    from loops in other TUs rank first.
+
+    A file whose analysis fails (e.g. libclang cannot load it) is skipped
+    with a warning; the other files' results are kept, and the failures are
+    listed in the returned pipeline's `errors`.
+
+    Args:
+        compdb: Loaded CompilationDatabase; stays open, the caller closes it
+        files: Source files to check
+        checks_spec: Check filter passed to select_checks()
+        jobs: Number of analysis workers
+        timings: Dict accumulating seconds per phase and per check
+        backend: "threads" for one Index per thread in this process,
+            "processes" for a process pool the analysis threads hand files to
+        cache: Optional AnalysisCache shared by all workers
+        pin: Worker placement, one of affinity.PIN_MODES: "node" keeps each
+            worker (thread or process) on one NUMA node, "cpu" on one CPU;
+            with threads, each node gets its own classification cache
+
+    Returns:
+        Tuple (issues sorted by hotness, merged call graph, hotness scores,
+        pipeline.Pipeline with per-stage occupancy)
+    """
+    from pipeline import Pipeline
+
+    jobs = max(jobs, 1)
+    placements = plan_placements(jobs, pin)
+    executor = None
+    if backend == "processes":
+        cache_args = (None, None) if cache is None else (str(cache.root), cache.max_size)
+        import multiprocessing
+        from concurrent.futures import ProcessPoolExecutor
+
+        placement_queue = None
+        if placements:
+            placement_queue = multiprocessing.Queue()
+            for placement in placements:
+                placement_queue.put(placement)
+        executor = ProcessPoolExecutor(
+            max_workers=jobs,
+            initializer=_init_project_worker,
+            initargs=(VERBOSE, *cache_args, placement_queue),
+        )
+        # The analysis threads only wait for the processes; leave them unpinned
+        placements = []
+    thread_placements = PlacementPool(placements)
+
+    def prepare(job: ProjectJob):
+        try:
+            with open(job.filename, "r", encoding="utf-8") as f:
+                job.source_lines = f.readlines()
+            job.args = get_compile_args(compdb, job.filename)
+        except (OSError, ValueError) as e:
+            print(f"Warning: skipping {job.filename}: {e}", file=sys.stderr)
+            return None
+        if cache is not None:
+            job.cache_key = result_cache_key(
+                job.filename,
+                "".join(job.source_lines),
+                job.args,
+                select_checks(checks_spec) + [CallGraphCollector()],
+            )
+        return job
+
+    def probe_cache(job: ProjectJob):
+        collector = CallGraphCollector()
+        checks = select_checks(checks_spec) + [collector]
+        cached = load_cached_result(cache, job.cache_key, checks)
+        if cached is None:
+            count_cache_event(job.timings, "cache-misses")
+        else:
+            count_cache_event(job.timings, "cache-hits")
+            job.result = (cached, collector.edges, {})
+        return job
+
+    def analyze(job: ProjectJob):
+        if VERBOSE:
+            print(f"[DEBUG] Analyzing {job.filename}...")
+        if executor is not None:
+            job.result = executor.submit(
+                _analyze_in_worker,
+                job.filename,
+                job.source_lines,
+                job.args,
+                checks_spec,
+                job.cache_key,
+            ).result()
+        else:
+            index = getattr(_THREAD_STATE, "index", None)
+            if index is None:
+                placement = thread_placements.claim()
+                if placement is not None and _pin_worker(
+                    placement, f"thread {threading.current_thread().name}"
+                ):
+                    _THREAD_STATE.classification_cache = (
+                        _NODE_CLASSIFICATION_CACHES.setdefault(placement.node, {})
+                    )
+                # Allocated after pinning, so that its memory is local to the node
+                index = _THREAD_STATE.index = clang.cindex.Index.create()
+            job.result = analyze_project_file(
+                job.filename,
+                job.source_lines,
+                job.args,
+                checks_spec,
+                index,
+                cache,
+                job.cache_key,
+            )
+        # The source is not needed past this stage
+        job.source_lines = None
+        return job
+
+    results = {}
+
+    def report(job: ProjectJob):
+        file_issues, edges, file_timings = job.result
+        results[job.filename] = (file_issues, edges)
+        for file_timings in (job.timings, file_timings):
+            for name, seconds in file_timings.items():
+                timings[name] = timings.get(name, 0.0) + seconds
+        return None
+
+    pipeline = Pipeline(queue_size=max(PIPELINE_QUEUE_PER_WORKER * jobs, 4))
+    pipeline.add_stage("prepare", prepare, workers=2)
+    if cache is not None:
+        pipeline.add_stage("cache-probe", probe_cache, workers=2)
+    pipeline.add_stage(
+        "analyze", analyze, workers=jobs, passthrough=lambda job: job.result is not None
+    )
+    pipeline.add_stage("report", report)
+    try:
+        pipeline.run(ProjectJob(filename) for filename in files)
+    finally:
+        if executor is not None:
+            executor.shutdown()
+
+    for stage, job, error in pipeline.errors:
+        print(f"Warning: skipping {job.filename} ({stage}): {error}", file=sys.stderr)
+
+    # Files finish out of order; merge in input order for a stable report
+    issues = []
+    edge_lists = []
+    for filename in files:
+        if filename in results:
+            file_issues, edges = results[filename]
+            issues.extend(file_issues)
+            edge_lists.append(edges)
+
+    graph_start = time.perf_counter()
+    callers = merge_call_graph(edge_lists)
+    hotness = propagate_hotness(callers)
+    issues = rank_issues(issues, hotness)
+    # "call-graph" holds the per-TU edge collection of CallGraphCollector
+    timings["call-graph-merge"] = timings.get("call-graph-merge", 0.0) + (
+        time.perf_counter() - graph_start
+    )
+
+    return issues, callers, hotness, pipeline
+
+
+def plan_project_headers(build_dir: str, root: str, timings: dict) -> tuple:
+    """
+    Find the project headers of a compilation database (--headers).
+
+    Args:
+        build_dir: Directory containing compile_commands.json
+        root: Project root; headers outside it are external (default:
+            header_mode.default_header_root())
+        timings: Dict accumulating seconds per phase
+
+    Returns:
+        Tuple (list of header_mode.HeaderUnit, dict of shared preambles)
+
+    Raises:
+        ValueError: If no root is given and none can be derived
+    """
+    from header_mode import default_header_root, plan_headers
+
+    compdb = load_compilation_database(build_dir, timings)
+    files = list_project_files(compdb)
+    scan_start = time.perf_counter()
+    units = []
+    for filename in files:
+        try:
+            units.append((filename, get_compile_args(compdb, filename)))
+        except ValueError as e:
+            print(f"Warning: skipping {filename}: {e}", file=sys.stderr)
+    compdb.close()
+
+    if root is None:
+        root = default_header_root(build_dir, files)
+    headers, preambles = plan_headers(units, root)
+    timings["header-scan"] = time.perf_counter() - scan_start
+
+    if VERBOSE:
+        print(f"[DEBUG] Project root for headers: {root}")
+        for unit in headers:
+            print(f"[DEBUG] {unit.header}: flags from {unit.includer}")
+
+    return headers, preambles
+
+
+def check_headers(
+    headers: list, preambles: dict, checks_spec: str, jobs: int, timings: dict
+) -> list:
+    """
+    Check each project header once through a synthesized translation unit.
+
+    The shared preamble of every flag set in use is precompiled first; the
+    headers are then parsed on top of it on `jobs` threads. A header whose
+    synthesized TU has parse errors is still checked, but counts as a
+    failure: its findings may be incomplete.
+
+    Args:
+        headers: header_mode.HeaderUnit list from plan_project_headers()
+        preambles: Shared preambles from plan_project_headers()
+        checks_spec: Check filter passed to select_checks()
+        jobs: Number of parsing threads
+        timings: Dict accumulating seconds per phase and per check
+
+    Returns:
+        Tuple (list of issue dicts in header order, list of (header, first
+        parse error) for headers that failed to parse)
+    """
+    import tempfile
+    from concurrent.futures import ThreadPoolExecutor
+
+    from header_mode import build_preamble, parse_header
+
+    with tempfile.TemporaryDirectory(prefix="eigen-auto-headers-") as work_dir:
+        preamble_start = time.perf_counter()
+        index = clang.cindex.Index.create()
+        pchs = {}
+        for key in sorted({unit.preamble_key for unit in headers}):
+            args, lines = preambles[key]
+            pchs[key] = build_preamble(index, work_dir, key, args, lines)
+            if VERBOSE:
+                state = "precompiled" if pchs[key] else "failed, parsing without it"
+                print(f"[DEBUG] Preamble {key} ({len(lines)} line(s)): {state}")
+        timings["preamble"] = time.perf_counter() - preamble_start
+
+        def check_header(unit) -> tuple:
+            thread_index = getattr(_THREAD_STATE, "index", None)
+            if thread_index is None:
+                thread_index = _THREAD_STATE.index = clang.cindex.Index.create()
+            header_timings = {}
+            with open(unit.header, "r", encoding="utf-8") as f:
+                source_lines = f.readlines()
+
+            parse_start = time.perf_counter()
+            translation_unit = parse_header(
+                thread_index,
+                work_dir,
+                unit,
+                pchs[unit.preamble_key],
+                preambles[unit.preamble_key][1],
+            )
+            header_timings["parse"] = time.perf_counter() - parse_start
+            report_diagnostics(translation_unit)
+            # Formatted here: diagnostics must not outlive their TU
+            errors = [
+                f"{diag.location.file}:{diag.location.line}: {diag.spelling}"
+                for diag in translation_unit.diagnostics
+                if diag.severity >= clang.cindex.Diagnostic.Error
+            ]
+
+            issues = run_checks(
+                translation_unit,
+                unit.header,
+                source_lines,
+                select_checks(checks_spec),
+                header_timings,
+            )
+            return issues, header_timings, errors[0] if errors else None
+
+        with ThreadPoolExecutor(max_workers=max(jobs, 1)) as executor:
+            results = list(executor.map(check_header, headers))
+
+    issues = []
+    failures = []
+    for unit, (header_issues, header_timings, error) in zip(headers, results):
+        issues.extend(header_issues)
+        for name, seconds in header_timings.items():
+            timings[name] = timings.get(name, 0.0) + seconds
+        if error is not None:
+            failures.append((unit.header, error))
+    return issues, failures
+
+
+def print_timings(timings: dict, checks: list, issues: list, pipeline=None) -> None:
+    """Print the per-phase and per-check time table to stderr.
+
+    With a pipeline, also print each stage's busy time, utilization of its
+    workers and input queue occupancy; a stage near 100% with a full input
+    queue is the bottleneck.
+    """
+    print("Timings:", file=sys.stderr)
+    for phase in (
+        "startup",
+        "libclang-load",
+        "compdb-load",
+        "header-scan",
+        "preamble",
+        "parse",
+        "traversal",
+        "call-graph",
+        "call-graph-merge",
+    ):
+        if phase in timings:
+            print(f"  {phase:<24} {timings[phase]:8.3f}s", file=sys.stderr)
+    for check in checks:
+        count = sum(1 for issue in issues if issue.get("check") == check.name)
+        print(
+            f"  {check.name:<24} {timings.get(check.name, 0.0):8.3f}s"
+            f"  ({count} finding(s))",
+            file=sys.stderr,
+        )
+    if pipeline is not None:
+        print(
+            f"Pipeline stages ({pipeline.wall_s:.3f}s wall, "
+            f"queue size {pipeline.queue_size}):",
+            file=sys.stderr,
+        )
+        for stage in pipeline.stats:
+            print(
+                f"  {stage.name:<12} x{stage.workers:<3} {stage.items:6} item(s)"
+                f" {stage.busy_s:8.3f}s busy {100 * stage.utilization(pipeline.wall_s):5.1f}%"
+                f"  queue avg {stage.queue_mean:4.1f} max {stage.queue_max}",
+                file=sys.stderr,
+            )
+
+
+def format_message(issue: dict) -> str:
+    """Return the human-readable message for an issue."""
+    if "message" in issue:
+        return issue["message"]
+    return (
+        f"'{issue['variable']}' uses {issue['auto_kind']} "
+        "with Eigen expression template"
+    )
+
+
+def startup_seconds() -> float:
+    """
+    Seconds from process start to now.
+
+    Uses the process start time from /proc where available, so interpreter
+    start-up is included; otherwise counts from the checker's first import.
+    """
+    try:
+        with open("/proc/self/stat", "r") as f:
+            # Field 22 is the start time in clock ticks after boot; the fields
+            # after the parenthesized command name start at field 3
+            start_ticks = int(f.read().rsplit(")", 1)[1].split()[19])
+        return time.clock_gettime(time.CLOCK_BOOTTIME) - start_ticks / os.sysconf(
+            "SC_CLK_TCK"
+        )
+    except (OSError, ValueError, IndexError, AttributeError):
+        return time.perf_counter() - _IMPORT_START
 
 
 def main():
     global VERBOSE
 
+    if len(sys.argv) > 1 and sys.argv[1] == "cache":
+        import analysis_cache
+
+        return analysis_cache.main(sys.argv[2:])
+
     parser = argparse.ArgumentParser(
         description="Check for dangerous auto usage with Eigen expression templates",
         epilog="Examples:\n"
         "  uv run eigen_auto_check.py ../examples.cpp ../build\n"
-        "  uv run eigen_auto_check.py ../examples.cpp ../build --verbose",
+        "  uv run eigen_auto_check.py ../examples.cpp ../build --verbose\n"
+        "  uv run eigen_auto_check.py ../examples.cpp ../build --checks=-expensive\n"
+        "  uv run eigen_auto_check.py ../examples.cpp -- -std=c++20 -I/usr/include/eigen3",
         formatter_class=argparse.RawDescriptionHelpFormatter,
     )
-    parser.add_argument("source_file", help="C++ source file to check")
     parser.add_argument(
-        "build_dir", help="Build directory containing compile_commands.json"
+        "source_file",
+        nargs="?",
+        help="C++ source file to check (omit with --all)",
+    )
+    parser.add_argument(
+        "build_dir",
+        nargs="?",
+        help="Build directory containing compile_commands.json (omit when "
+        "compiler flags follow --)",
     )
     parser.add_argument(
         "--verbose", "-v", action="store_true", help="Enable verbose debug output"
     )
+    parser.add_argument(
+        "--checks",
+        default="*",
+        help="Comma-separated check filter; globs allowed, '-' prefix disables, "
+        "'expensive' matches all expensive checks (default: '*')",
+    )
+    parser.add_argument(
+        "--list-checks", action="store_true", help="List available checks and exit"
+    )
+    parser.add_argument(
+        "--all",
+        action="store_true",
+        help="Check every file in the compilation database and rank findings "
+        "by call-graph hotness",
+    )
+    parser.add_argument(
+        "--headers",
+        action="store_true",
+        help="Check every project header once through a synthesized translation "
+        "unit with flags borrowed from an includer",
+    )
+    parser.add_argument(
+        "--header-root",
+        metavar="DIR",
+        help="With --headers, only headers under DIR belong to the project "
+        "(default: common parent of all sources, and of the build directory "
+        "if it is inside the project)",
+    )
+    parser.add_argument(
+        "--jobs",
+        "-j",
+        type=int,
+        default=os.cpu_count() or 1,
+        help="Workers for --all and --headers (default: number of CPUs)",
+    )
+    parser.add_argument(
+        "--backend",
+        choices=("threads", "processes"),
+        default="threads",
+        help="Parallel backend for --all: threads in this process sharing the "
+        "compilation database and caches, or a process pool (default: threads)",
+    )
+    parser.add_argument(
+        "--pin",
+        choices=PIN_MODES,
+        default="none",
+        help="Worker placement for --all: 'node' spreads workers over NUMA "
+        "nodes and keeps each on its node, 'cpu' also gives each its own CPU "
+        "(default: none)",
+    )
+    parser.add_argument(
+        "--call-graph",
+        metavar="FILE",
+        help="With --all, write the merged call graph and hotness scores as JSON",
+    )
+    parser.add_argument(
+        "--watch",
+        action="store_true",
+        help="Re-check source_file whenever it changes, re-analyzing only "
+        "functions whose fingerprint changed",
+    )
+    parser.add_argument(
+        "--stdin",
+        action="store_true",
+        help="Read the contents of source_file from stdin instead of disk, "
+        "e.g. an unsaved editor buffer",
+    )
+    parser.add_argument(
+        "--unsaved-files",
+        metavar="JSON",
+        help="JSON object mapping paths to contents that replace the files on "
+        "disk ('-' reads it from stdin)",
+    )
+    parser.add_argument(
+        "--serve",
+        action="store_true",
+        help="Check editor buffers sent as JSON lines on stdin, answering with "
+        "JSON lines on stdout",
+    )
+    parser.add_argument(
+        "--debounce",
+        type=float,
+        default=0.15,
+        help="With --serve, wait this many seconds without a newer request "
+        "before checking a file (default: 0.15)",
+    )
+    parser.add_argument(
+        "--watch-interval",
+        type=float,
+        default=0.5,
+        help="Polling interval in seconds for --watch (default: 0.5)",
+    )
+    parser.add_argument(
+        "--engine",
+        choices=("libclang", "clang-tidy"),
+        default="libclang",
+        help="Analyze with libclang from Python, or with the native clang-tidy "
+        "plugin (eigen-auto only; default: libclang)",
+    )
+    parser.add_argument(
+        "--clang-tidy-plugin",
+        metavar="PATH",
+        help="EigenAutoCheckPlugin.so built with -DBUILD_CLANG_TIDY_PLUGIN=ON",
+    )
+    parser.add_argument(
+        "--clang-tidy",
+        default="clang-tidy",
+        metavar="PATH",
+        help="clang-tidy executable for --engine=clang-tidy",
+    )
+    parser.add_argument(
+        "--cache-dir",
+        help="Shared result cache directory; files whose source, flags and "
+        f"headers are unchanged are not re-analyzed (default: ${CACHE_DIR_ENV})",
+    )
+    parser.add_argument(
+        "--cache-max-size",
+        default=DEFAULT_MAX_SIZE,
+        help=f"Evict least recently used cache entries beyond this size "
+        f"(default: {DEFAULT_MAX_SIZE})",
+    )
+    parser.add_argument(
+        "--no-cache", action="store_true", help="Do not use the result cache"
+    )
+    parser.add_argument(
+        "--stamp",
+        metavar="FILE",
+        help="Touch FILE after checking source_file, for build system "
+        "integration; not written if the check fails",
+    )
+    parser.add_argument(
+        "--depfile",
+        metavar="FILE",
+        help="With --stamp, write a Make/Ninja depfile listing every file the "
+        "translation unit included",
+    )
+    parser.add_argument(
+        "--exit-zero",
+        action="store_true",
+        help="Exit with status 0 even if issues are found",
+    )
+    parser.add_argument(
+        "--timings",
+        action="store_true",
+        help="Report parse, traversal and per-check time on stderr",
+    )
+
+    # Everything after "--" is compiler flags, passed through untouched
+    argv = sys.argv[1:]
+    direct_flags = None
+    if "--" in argv:
+        split = argv.index("--")
+        argv, direct_flags = argv[:split], argv[split + 1 :]
+
+    args = parser.parse_args(argv)
+
+    if args.list_checks:
+        for name, cls in available_checks().items():
+            marker = " (expensive)" if cls.expensive else ""
+            print(f"{name}{marker}: {cls.description}")
+        return 0
 
-    args = parser.parse_args()
+    project_mode = args.all or args.headers
+    if args.serve and direct_flags is None and args.build_dir is None:
+        # "--serve ../build": the single positional is the build directory
+        args.source_file, args.build_dir = None, args.source_file
+    if project_mode and args.build_dir is None:
+        # "--all ../build": the single positional is the build directory
+        args.source_file, args.build_dir = None, args.source_file
+    if args.all and args.headers:
+        parser.error("--headers cannot be combined with --all")
+    if project_mode and args.source_file:
+        parser.error("source_file cannot be combined with --all or --headers")
+    buffer_mode = args.stdin or args.unsaved_files
+    if args.serve:
+        if project_mode or args.watch or buffer_mode or args.stamp:
+            parser.error("--serve cannot be combined with other modes")
+        if args.engine == "clang-tidy":
+            parser.error("--serve requires --engine=libclang")
+        if args.source_file:
+            parser.error("--serve takes a build directory, not a source file")
+    elif direct_flags is not None:
+        if project_mode or args.watch or args.engine == "clang-tidy":
+            parser.error("compiler flags after -- support single-file libclang runs only")
+        if args.build_dir:
+            parser.error("build_dir cannot be combined with compiler flags after --")
+        if not args.source_file:
+            parser.error("source_file is required")
+    elif not project_mode and (not args.source_file or not args.build_dir):
+        parser.error("source_file and build_dir are required")
+    if buffer_mode and (project_mode or args.watch or args.engine == "clang-tidy"):
+        parser.error("--stdin and --unsaved-files support single-file libclang runs only")
+    if buffer_mode and args.stamp:
+        parser.error("--stamp certifies files on disk; it cannot check unsaved buffers")
+    if args.stdin and args.unsaved_files == "-":
+        parser.error("--stdin cannot be combined with --unsaved-files -")
+    if args.header_root and not args.headers:
+        parser.error("--header-root requires --headers")
+    if args.stamp and (project_mode or args.watch):
+        parser.error("--stamp supports single files only")
+    if args.depfile and not args.stamp:
+        parser.error("--depfile requires --stamp")
+    if args.call_graph and not args.all:
+        parser.error("--call-graph requires --all")
+    if args.watch and project_mode:
+        parser.error("--watch cannot be combined with --all or --headers")
+    if args.engine == "clang-tidy":
+        if project_mode or args.watch:
+            parser.error("--engine=clang-tidy supports single files only")
+        if not args.clang_tidy_plugin:
+            parser.error("--engine=clang-tidy requires --clang-tidy-plugin")
+        # The clang-tidy run reports no include list, timings or cache state
+        for option, given in (
+            ("--stamp", args.stamp),
+            ("--timings", args.timings),
+            ("--cache-dir", args.cache_dir),
+        ):
+            if given:
+                parser.error(f"{option} is not supported with --engine=clang-tidy")
+
+    try:
+        checks = select_checks(args.checks)
+        cache = open_cache(args)
+    except ValueError as e:
+        parser.error(str(e))
 
     VERBOSE = args.verbose
     source_file = args.source_file
     build_dir = args.build_dir
 
+    if args.all:
+        return run_project(args, checks, cache)
+    if args.headers:
+        return run_headers(args, checks)
+    if args.serve:
+        compdb = None
+        if direct_flags is None:
+            compdb = load_compilation_database(build_dir)
+        try:
+            serve(compdb, direct_flags, checks, args.debounce)
+        except KeyboardInterrupt:
+            pass
+        return 0
+
     # Resolve to absolute path
     source_path = Path(source_file).resolve()
-    if not source_path.exists():
+    unsaved_files = None
+    if buffer_mode:
+        try:
+            unsaved_files = (
+                read_unsaved_files(args.unsaved_files) if args.unsaved_files else {}
+            )
+        except (OSError, ValueError) as e:
+            parser.error(f"--unsaved-files: {e}")
+        if args.stdin:
+            unsaved_files[str(source_path)] = sys.stdin.read()
+    if not source_path.exists() and str(source_path) not in (unsaved_files or {}):
         print(f"Error: File not found: {source_file}", file=sys.stderr)
         sys.exit(1)
 
     if not VERBOSE:
         print(f"Checking {source_path}...")
 
-    # Load compilation database once
-    compdb = load_compilation_database(build_dir)
+    if args.engine == "clang-tidy":
+        import clang_tidy_engine
+
+        selected = {check.name for check in checks}
+        missing = sorted(selected - clang_tidy_engine.CHECKS)
+        if missing and args.checks != "*":
+            parser.error(
+                f"--engine=clang-tidy does not implement {', '.join(missing)}; "
+                f"select from {', '.join(sorted(clang_tidy_engine.CHECKS))}"
+            )
+        if missing:
+            print(
+                f"Note: --engine=clang-tidy skips {', '.join(missing)} "
+                "(libclang engine only)",
+                file=sys.stderr,
+            )
+        issues = []
+        if selected & clang_tidy_engine.CHECKS:
+            with open(source_path, "r", encoding="utf-8") as f:
+                source_lines = f.readlines()
+            try:
+                issues = clang_tidy_engine.check_file_clang_tidy(
+                    str(source_path),
+                    build_dir,
+                    args.clang_tidy_plugin,
+                    source_lines,
+                    args.clang_tidy,
+                )
+            except RuntimeError as e:
+                print(f"Error: {e}", file=sys.stderr)
+                return 2
+        exit_code = report_issues(issues)
+        return 0 if args.exit_zero else exit_code
+
+    timings = {"startup": startup_seconds()}
+
+    # Loading the libclang library is part of cold start; measure it apart
+    load_start = time.perf_counter()
+    index = clang.cindex.Index.create()
+    timings["libclang-load"] = time.perf_counter() - load_start
+
+    if direct_flags is not None:
+        compdb, compile_args = None, direct_flags
+    else:
+        compdb = load_compilation_database(build_dir, timings, str(source_path))
+        compile_args = None
+
+    file_args = compile_args
+    if file_args is None:
+        # Fail before watching or parsing if the database lacks the file
+        try:
+            file_args = get_compile_args(compdb, str(source_path))
+        except ValueError as e:
+            print(f"Error: {e}", file=sys.stderr)
+            return 2
+
+    if args.watch:
+        try:
+            watch_file(
+                str(source_path), compdb, checks, args.watch_interval, args.timings
+            )
+        except KeyboardInterrupt:
+            pass
+        return 0
 
     # Check the file
-    issues = check_file(str(source_path), compdb)
+    dependencies = [] if args.depfile else None
+    issues = check_file(
+        str(source_path),
+        compdb,
+        checks,
+        timings,
+        index=index,
+        compile_args=file_args,
+        cache=cache,
+        dependencies=dependencies,
+        unsaved_files=unsaved_files,
+    )
+
+    if args.timings:
+        print_timings(timings, checks, issues)
+    finish_cache(cache, timings)
+
+    exit_code = report_issues(issues)
+    if args.exit_zero:
+        exit_code = 0
+    if args.stamp and exit_code == 0:
+        write_stamp(args.stamp, args.depfile, str(source_path), dependencies)
+    return exit_code
+
+
+def run_project(args, checks: list, cache: AnalysisCache = None) -> int:
+    """Check every file of the compilation database (--all)."""
+    timings = {}
+    compdb = load_compilation_database(args.build_dir, timings)
+    files = list_project_files(compdb)
+
+    print(f"Checking {len(files)} file(s) from {Path(args.build_dir).resolve()}...")
+
+    try:
+        issues, callers, hotness, pipeline = check_project(
+            compdb,
+            files,
+            args.checks,
+            args.jobs,
+            timings,
+            args.backend,
+            cache,
+            args.pin,
+        )
+    finally:
+        compdb.close()
+
+    if args.call_graph:
+        write_call_graph(args.call_graph, callers, hotness)
+
+    if args.timings:
+        print_timings(timings, checks, issues, pipeline)
+    finish_cache(cache, timings)
+
+    exit_code = report_issues(issues)
+    if pipeline.errors:
+        print(
+            f"Error: {len(pipeline.errors)} of {len(files)} file(s) could not be checked",
+            file=sys.stderr,
+        )
+        exit_code = 1
+    return exit_code
+
+
+def run_headers(args, checks: list) -> int:
+    """Check every project header once (--headers)."""
+    timings = {}
+    try:
+        headers, preambles = plan_project_headers(
+            args.build_dir, args.header_root, timings
+        )
+    except ValueError as e:
+        print(f"Error: cannot determine the project root: {e}", file=sys.stderr)
+        return 2
 
+    print(f"Checking {len(headers)} header(s) from {Path(args.build_dir).resolve()}...")
+
+    issues, failures = check_headers(headers, preambles, args.checks, args.jobs, timings)
+    for header, error in failures:
+        print(f"Warning: {header} does not parse in header mode: {error}", file=sys.stderr)
+
+    if args.timings:
+        print_timings(timings, checks, issues)
+
+    exit_code = report_issues(issues)
+    if failures:
+        print(
+            f"Error: {len(failures)} of {len(headers)} header(s) failed to parse "
+            "in header mode; their findings may be incomplete",
+            file=sys.stderr,
+        )
+        exit_code = 1
+    return exit_code
+
+
+def report_issues(issues: list) -> int:
+    """
+    Print issues in compiler-style format.
+
+    Issues ranked by hotness that are only reachable from cold code are
+    reported as warnings after the hot ones.
+
+    Returns:
+        Process exit code (1 if there are issues)
+    """
     if not issues:
         print(f"✓ No issues found")
         return 0
@@ -410,12 +2140,20 @@ def main():
     print(f"Found {len(issues)} issue(s):\n")
 
     for issue in issues:
+        severity = "error"
+        if issue.get("hotness", COLD_HOTNESS + 1) <= COLD_HOTNESS:
+            severity = "warning"
         print(
-            f"{issue['file']}:{issue['line']}:{issue['column']}: error: "
-            f"'{issue['variable']}' uses {issue['auto_kind']} with Eigen expression template"
+            f"{issue['file']}:{issue['line']}:{issue['column']}: {severity}: "
+            f"{format_message(issue)} [{issue['check']}]"
         )
-        print(f"  Type: {issue['type']}")
+        if "type" in issue:
+            print(f"  Type: {issue['type']}")
+        if "hotness" in issue:
+            print(f"  Hotness: {issue['hotness']:g}")
         print(f"  Source: {issue['source']}")
+        if "suggestion" in issue:
+            print(f"  Suggestion: {issue['suggestion']}")
         print()
 
     return 1
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""
+Helpers on libclang types and source text shared by the checker's engines.
+
+They live apart from eigen_auto_check.py so that modules used by the checker
+(e.g. clang_tidy_engine.py) can import them without importing the checker
+script a second time, which would re-run its check registrations.
+"""
+
+import clang.cindex
+
+
+def strip_reference(type_obj: clang.cindex.Type) -> clang.cindex.Type:
+    """
+    Strip reference wrappers from a type.
+    Similar to std::remove_reference in C++.
+
+    Args:
+        type_obj: The Type object to strip
+
+    Returns:
+        The type after stripping references
+    """
+    stripped = type_obj
+
+    # For reference types, get the pointee (the type being referenced)
+    if (
+        stripped.kind == clang.cindex.TypeKind.LVALUEREFERENCE
+        or stripped.kind == clang.cindex.TypeKind.RVALUEREFERENCE
+    ):
+        stripped = stripped.get_pointee()
+
+    return stripped
+
+
+def get_unqualified_type_name(type_obj: clang.cindex.Type) -> str:
+    """
+    Get the type name with references and const qualifiers removed.
+    Similar to std::remove_cvref in C++.
+
+    Args:
+        type_obj: The Type object
+
+    Returns:
+        The spelling of the type without const and references
+    """
+    stripped = strip_reference(type_obj)
+    type_spelling = stripped.spelling
+
+    # Remove 'const ' prefix if present
+    return type_spelling.removeprefix("const ")
+
+
+def is_in_eigen_namespace(type_obj: clang.cindex.Type) -> bool:
+    """
+    Check if a type is declared within the Eigen namespace.
+
+    Args:
+        type_obj: The Type object to check
+
+    Returns:
+        True if the type is in the Eigen namespace, False otherwise
+    """
+    stripped_type = strip_reference(type_obj)
+    decl = stripped_type.get_declaration()
+    if not decl or decl.kind == clang.cindex.CursorKind.NO_DECL_FOUND:
+        return False
+
+    # Walk up the semantic parent chain looking for a namespace named "Eigen"
+    parent = decl.semantic_parent
+    while parent:
+        if (
+            parent.kind == clang.cindex.CursorKind.NAMESPACE
+            and parent.spelling == "Eigen"
+        ):
+            return True
+        if parent.kind == clang.cindex.CursorKind.TRANSLATION_UNIT:
+            break
+        parent = parent.semantic_parent
+
+    return False
+
+
+def get_source_range(lines: list, start_line: int, end_line: int) -> str:
+    """
+    Get a range of source lines from pre-loaded file content.
+
+    Args:
+        lines: List of lines from the source file
+        start_line: Starting line number (1-indexed)
+        end_line: Ending line number (1-indexed)
+
+    Returns:
+        Joined string of the line range
+    """
+    if 1 <= start_line <= len(lines) and 1 <= end_line <= len(lines):
+        # Get all lines in the range
+        source_lines = [lines[i - 1].rstrip() for i in range(start_line, end_line + 1)]
+        # Join with spaces to make it a single line for display
+        return " ".join(line.strip() for line in source_lines if line.strip())
+    return "?"
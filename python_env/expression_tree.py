@@ -0,0 +1,648 @@
+#!/usr/bin/env python3
+"""
+Dump Eigen expression types as trees with estimated per-node cost.
+
+For every Eigen-typed variable declaration in a file (and with --expressions,
+every outermost Eigen expression), the canonical type spelling is parsed into
+a tree of nodes with kind, scalar, sizes, storage order and operands. Each
+node carries its own estimated FLOPs and bytes and the totals of its subtree,
+with the conventions of include/eigen_auto/cost_model.h: one FLOP per
+coefficient of a coefficient-wise operation, 2 * M * K * N per product,
+plain operands read once and product temporaries written once.
+
+Sizes that are dynamic in the type are reported as "dynamic"; their costs
+are null unless --dynamic-size gives a size to assume.
+
+Usage:
+    uv run expression_tree.py ../examples.cpp ../build
+    uv run expression_tree.py ../examples.cpp ../build --format text --dynamic-size 3
+    uv run expression_tree.py ../examples.cpp --expressions -- -std=c++20 -I/usr/include/eigen3
+"""
+
+import argparse
+import json
+import re
+import sys
+from pathlib import Path
+
+import clang.cindex
+
+import eigen_auto_check as checker
+
+# Bytes per coefficient of the scalar types Eigen is commonly used with
+SCALAR_BYTES = {
+    "bool": 1,
+    "char": 1,
+    "short": 2,
+    "int": 4,
+    "unsigned int": 4,
+    "float": 4,
+    "long": 8,
+    "unsigned long": 8,
+    "long long": 8,
+    "double": 8,
+    "long double": 16,
+    "std::complex<float>": 8,
+    "std::complex<double>": 16,
+}
+
+# Eigen's marker for a size only known at run time
+DYNAMIC = -1
+
+# Bit of the Matrix/Array Options argument that selects row-major storage
+ROW_MAJOR_BIT = 0x1
+
+_TOKEN_RE = re.compile(r"\s*(::|&&|[<>,()&*\[\]]|[A-Za-z_]\w*|-?\d+\w*|\S)")
+
+
+# ============================================================================
+# Type spelling parser
+# ============================================================================
+
+
+class TypeName:
+    """A parsed type spelling: qualified name, template arguments, const."""
+
+    __slots__ = ("name", "args", "const")
+
+    def __init__(self, name: str, args: list, const: bool):
+        self.name = name
+        self.args = args
+        self.const = const
+
+    @property
+    def short_name(self) -> str:
+        """The name without namespaces, e.g. 'Product'."""
+        return self.name.rsplit("::", 1)[-1]
+
+    def spelling(self) -> str:
+        """Spell the type again, as clang would."""
+        if not self.args:
+            return self.name
+        args = ", ".join(
+            arg.spelling() if isinstance(arg, TypeName) else str(arg) for arg in self.args
+        )
+        return f"{self.name}<{args}>"
+
+
+def tokenize_type(spelling: str) -> list:
+    """Split a type spelling into names, numbers and punctuation."""
+    return _TOKEN_RE.findall(spelling)
+
+
+def parse_type(spelling: str) -> TypeName:
+    """
+    Parse a canonical type spelling into a TypeName tree.
+
+    Args:
+        spelling: e.g. "const Eigen::Product<Eigen::Matrix<double, 3, 3>, ...>"
+
+    Returns:
+        TypeName of the outermost type; template arguments are TypeName,
+        int or bool
+    """
+    tokens = tokenize_type(spelling)
+    position = 0
+
+    def peek():
+        return tokens[position] if position < len(tokens) else None
+
+    def take():
+        nonlocal position
+        position += 1
+        return tokens[position - 1]
+
+    def parse_argument():
+        token = peek()
+        if token is not None and re.fullmatch(r"-?\d+\w*", token):
+            take()
+            return int(re.match(r"-?\d+", token).group())
+        if token in ("true", "false"):
+            take()
+            return token == "true"
+        return parse_name()
+
+    def parse_name() -> TypeName:
+        const = False
+        parts = []
+        args = []
+        while True:
+            token = peek()
+            if token == "const":
+                take()
+                const = True
+            elif token == "::":
+                take()
+                parts.append("::")
+            elif token is not None and re.fullmatch(r"[A-Za-z_]\w*", token):
+                # "unsigned long": adjacent words without "::" form one name
+                if parts and parts[-1] != "::":
+                    parts.append(" ")
+                parts.append(take())
+            elif token == "<":
+                take()
+                args = []
+                while peek() not in (">", None):
+                    args.append(parse_argument())
+                    if peek() == ",":
+                        take()
+                if peek() == ">":
+                    take()
+                # A nested name after template arguments, e.g. Foo<T>::type
+                if peek() != "::":
+                    continue
+                parts.append("<" + ", ".join(_spell(arg) for arg in args) + ">")
+                args = []
+            elif token in ("&", "&&", "*"):
+                take()
+            else:
+                break
+        return TypeName("".join(parts), args, const)
+
+    return parse_name()
+
+
+def _spell(arg) -> str:
+    if isinstance(arg, TypeName):
+        return arg.spelling()
+    if isinstance(arg, bool):
+        return "true" if arg else "false"
+    return str(arg)
+
+
+# ============================================================================
+# Expression tree with cost estimates
+# ============================================================================
+
+
+def _size(value):
+    """Size for the JSON output: the number, or "dynamic"."""
+    return "dynamic" if value == DYNAMIC else value
+
+
+def _product(*factors):
+    """Product of sizes; None if a size is unknown or dynamic."""
+    result = 1
+    for factor in factors:
+        if factor is None or factor == DYNAMIC:
+            return None
+        result *= factor
+    return result
+
+
+def _add(*terms):
+    """Sum of costs; None if any is unknown."""
+    if any(term is None for term in terms):
+        return None
+    return sum(terms)
+
+
+def _is_eigen(arg) -> bool:
+    return isinstance(arg, TypeName) and arg.name.startswith("Eigen::") and (
+        not arg.name.startswith("Eigen::internal::")
+    )
+
+
+def _result_scalar(functor, operand: dict) -> str:
+    """Scalar of a coefficient-wise node: the functor's last argument, e.g.
+    scalar_cast_op<float, double>, if it is a scalar type."""
+    if isinstance(functor, TypeName) and functor.args:
+        last = _spell(functor.args[-1])
+        if last in SCALAR_BYTES:
+            return last
+    return operand["scalar"]
+
+
+def _functor_name(arg) -> str:
+    """'Eigen::internal::scalar_sum_op<double, double>' -> 'sum'."""
+    if not isinstance(arg, TypeName):
+        return None
+    name = arg.short_name
+    name = name.removeprefix("scalar_").removesuffix("_op")
+    return name
+
+
+class ExpressionBuilder:
+    """
+    Turns parsed Eigen types into expression tree nodes.
+
+    Args:
+        dynamic_size: Size assumed for dynamic dimensions in cost estimates,
+            or None to leave those costs unknown
+    """
+
+    def __init__(self, dynamic_size: int = None):
+        self.dynamic_size = dynamic_size
+
+    def _dim(self, value):
+        """A dimension for cost estimates, with dynamic_size substituted."""
+        if value == DYNAMIC:
+            return self.dynamic_size
+        return value
+
+    def _coefficients(self, node: dict):
+        return _product(self._dim(node["_rows"]), self._dim(node["_cols"]))
+
+    def _coefficient_bytes(self, node: dict):
+        return _product(self._coefficients(node), SCALAR_BYTES.get(node["scalar"]))
+
+    def build(self, type_name: TypeName) -> dict:
+        """
+        Build the expression tree node of an Eigen type.
+
+        Returns:
+            Dict with kind, scalar, rows, cols, operands and costs; every
+            node also keeps "_rows"/"_cols" for its parent, removed by
+            finish()
+        """
+        kind = type_name.short_name
+        args = type_name.args
+        handler = getattr(self, f"_build_{kind}", None)
+        if handler is not None and args:
+            node = handler(type_name, args)
+        else:
+            node = self._build_other(type_name, args)
+        node.setdefault("operands", [])
+        node["total_flops"] = _add(
+            node["flops"], *(operand["total_flops"] for operand in node["operands"])
+        )
+        node["total_bytes"] = _add(
+            node["bytes"], *(operand["total_bytes"] for operand in node["operands"])
+        )
+        node["depth"] = 1 + max(
+            (operand["depth"] for operand in node["operands"]), default=-1
+        )
+        return node
+
+    def _node(self, kind: str, scalar: str, rows, cols, **fields) -> dict:
+        node = {"kind": kind, "scalar": scalar, "_rows": rows, "_cols": cols}
+        node.update(fields)
+        return node
+
+    def _leaf(self, kind: str, plain: dict, rows=None, cols=None) -> dict:
+        """A node read from memory, with the storage of the plain object."""
+        node = self._node(
+            kind,
+            plain["scalar"],
+            plain["_rows"] if rows is None else rows,
+            plain["_cols"] if cols is None else cols,
+            storage=plain.get("storage"),
+            flops=0,
+        )
+        node["bytes"] = self._coefficient_bytes(node)
+        return node
+
+    def _view(self, kind: str, operand: dict, rows, cols) -> dict:
+        """A node forwarding to its operand at no cost of its own."""
+        return self._node(
+            kind, operand["scalar"], rows, cols, flops=0, bytes=0, operands=[operand]
+        )
+
+    # -- plain objects -------------------------------------------------------
+
+    def _build_Matrix(self, type_name: TypeName, args: list) -> dict:
+        scalar = _spell(args[0])
+        options = args[3] if len(args) > 3 and isinstance(args[3], int) else 0
+        node = self._node(
+            type_name.short_name,
+            scalar,
+            args[1],
+            args[2],
+            storage="row-major" if options & ROW_MAJOR_BIT else "col-major",
+            flops=0,
+        )
+        node["bytes"] = self._coefficient_bytes(node)
+        return node
+
+    _build_Array = _build_Matrix
+
+    def _build_Map(self, type_name: TypeName, args: list) -> dict:
+        return self._leaf(type_name.short_name, self.build(args[0]))
+
+    _build_Ref = _build_Map
+
+    # -- operations ----------------------------------------------------------
+
+    def _build_CwiseNullaryOp(self, type_name: TypeName, args: list) -> dict:
+        plain = self.build(args[1])
+        return self._node(
+            "CwiseNullaryOp",
+            _result_scalar(args[0], plain),
+            plain["_rows"],
+            plain["_cols"],
+            op=_functor_name(args[0]),
+            flops=0,
+            bytes=0,
+        )
+
+    def _build_CwiseUnaryOp(self, type_name: TypeName, args: list) -> dict:
+        operand = self.build(args[1])
+        node = self._node(
+            "CwiseUnaryOp",
+            _result_scalar(args[0], operand),
+            operand["_rows"],
+            operand["_cols"],
+            op=_functor_name(args[0]),
+            bytes=0,
+            operands=[operand],
+        )
+        node["flops"] = self._coefficients(node)
+        return node
+
+    def _build_CwiseBinaryOp(self, type_name: TypeName, args: list) -> dict:
+        lhs, rhs = self.build(args[1]), self.build(args[2])
+        rows = lhs["_rows"] if lhs["_rows"] != DYNAMIC else rhs["_rows"]
+        cols = lhs["_cols"] if lhs["_cols"] != DYNAMIC else rhs["_cols"]
+        node = self._node(
+            "CwiseBinaryOp",
+            _result_scalar(args[0], lhs),
+            rows,
+            cols,
+            op=_functor_name(args[0]),
+            bytes=0,
+            operands=[lhs, rhs],
+        )
+        node["flops"] = self._coefficients(node)
+        return node
+
+    def _build_Product(self, type_name: TypeName, args: list) -> dict:
+        lhs, rhs = self.build(args[0]), self.build(args[1])
+        node = self._node(
+            "Product", lhs["scalar"], lhs["_rows"], rhs["_cols"], operands=[lhs, rhs]
+        )
+        inner = self._dim(lhs["_cols"])
+        node["flops"] = _product(2, inner, self._coefficients(node))
+        # Evaluated into a temporary before any coefficient is used
+        node["bytes"] = self._coefficient_bytes(node)
+        return node
+
+    def _build_Transpose(self, type_name: TypeName, args: list) -> dict:
+        operand = self.build(args[0])
+        return self._view("Transpose", operand, operand["_cols"], operand["_rows"])
+
+    def _build_ArrayWrapper(self, type_name: TypeName, args: list) -> dict:
+        operand = self.build(args[0])
+        return self._view(
+            type_name.short_name, operand, operand["_rows"], operand["_cols"]
+        )
+
+    _build_MatrixWrapper = _build_ArrayWrapper
+
+    def _build_Block(self, type_name: TypeName, args: list) -> dict:
+        operand = self.build(args[0])
+        rows, cols = args[1], args[2]
+        if "storage" in operand and not operand["operands"]:
+            # A block of a plain object reads only the block
+            return self._leaf("Block", operand, rows, cols)
+        # A block of an expression costs the whole expression
+        return self._view("Block", operand, rows, cols)
+
+    def _build_other(self, type_name: TypeName, args: list) -> dict:
+        """Any other Eigen type: operands are shown, its sizes and cost are unknown."""
+        operands = [self.build(arg) for arg in args if _is_eigen(arg)]
+        return self._node(
+            type_name.short_name,
+            operands[0]["scalar"] if operands else None,
+            None,
+            None,
+            flops=None,
+            bytes=None,
+            operands=operands,
+            modeled=False,
+        )
+
+
+def finish(node: dict) -> dict:
+    """Replace the internal size fields with rows/cols for output."""
+    rows, cols = node.pop("_rows"), node.pop("_cols")
+    ordered = {
+        "kind": node.pop("kind"),
+        "scalar": node.pop("scalar"),
+        "rows": None if rows is None else _size(rows),
+        "cols": None if cols is None else _size(cols),
+    }
+    for key in ("storage", "op", "modeled"):
+        if key in node:
+            ordered[key] = node[key]
+    for key in ("flops", "bytes", "total_flops", "total_bytes", "depth"):
+        ordered[key] = node[key]
+    ordered["operands"] = [finish(operand) for operand in node["operands"]]
+    return ordered
+
+
+def expression_tree(spelling: str, dynamic_size: int = None) -> dict:
+    """
+    Parse a canonical Eigen type spelling into an expression tree.
+
+    Args:
+        spelling: Canonical type spelling, with or without const/reference
+        dynamic_size: Size assumed for dynamic dimensions, or None
+
+    Returns:
+        Root node dict (see module docstring)
+    """
+    return finish(ExpressionBuilder(dynamic_size).build(parse_type(spelling)))
+
+
+# ============================================================================
+# Collecting Eigen-typed declarations and expressions
+# ============================================================================
+
+
+# Expressions that only name something: variables are reported as
+# declarations, and member references have the type of a base class
+_NAMING_EXPRESSIONS = frozenset(
+    {clang.cindex.CursorKind.DECL_REF_EXPR, clang.cindex.CursorKind.MEMBER_REF_EXPR}
+)
+
+
+def _eigen_type(type_obj: clang.cindex.Type):
+    """The canonical type without references if it is an Eigen class, else None."""
+    canonical = checker.strip_reference(type_obj.get_canonical())
+    if canonical.kind != clang.cindex.TypeKind.RECORD:
+        return None
+    if not checker.is_in_eigen_namespace(canonical):
+        return None
+    return canonical
+
+
+def collect_entries(
+    translation_unit, filename: str, source_lines: list, expressions: bool
+) -> list:
+    """
+    Find Eigen-typed declarations (and outermost expressions) in a file.
+
+    Returns:
+        List of dicts with kind, name, line, column, source and canonical type
+    """
+    entries = []
+
+    def add(kind: str, cursor, name: str, canonical) -> None:
+        extent = cursor.extent
+        entries.append(
+            {
+                "kind": kind,
+                "name": name,
+                "line": extent.start.line,
+                "column": extent.start.column,
+                "source": checker.get_source_range(
+                    source_lines, extent.start.line, extent.end.line
+                ),
+                "type": canonical.spelling.removeprefix("const "),
+            }
+        )
+
+    def visit(cursor, inside_eigen_expression: bool) -> None:
+        for child in cursor.get_children():
+            location = child.location
+            if location.file is None or location.file.name != filename:
+                continue
+            eigen_expression = False
+            if child.kind == clang.cindex.CursorKind.VAR_DECL:
+                canonical = _eigen_type(child.type)
+                if canonical is not None:
+                    add("declaration", child, child.spelling, canonical)
+            elif (
+                expressions
+                and child.kind.is_expression()
+                and child.kind not in _NAMING_EXPRESSIONS
+            ):
+                canonical = _eigen_type(child.type)
+                # Plain results (MatrixXd M = A * B) are not interesting, the
+                # expression they are constructed from is
+                # Conversions to a base (DenseBase, EigenBase, ...) for member
+                # calls wrap the expression of interest
+                eigen_expression = (
+                    canonical is not None
+                    and not checker.is_allowed_auto_type(canonical)
+                    and not parse_type(canonical.spelling).short_name.endswith("Base")
+                )
+                # Implicit conversions and temporaries repeat the type of the
+                # expression they wrap: report only the outermost one, and
+                # not the initializer of a declaration reported above
+                if (
+                    eigen_expression
+                    and not inside_eigen_expression
+                    and cursor.kind != clang.cindex.CursorKind.VAR_DECL
+                ):
+                    add("expression", child, child.spelling, canonical)
+            visit(
+                child,
+                eigen_expression
+                or (inside_eigen_expression and child.kind.is_expression()),
+            )
+
+    visit(translation_unit.cursor, False)
+    return entries
+
+
+# ============================================================================
+# Output
+# ============================================================================
+
+
+def _cost(value) -> str:
+    return "?" if value is None else f"{value:g}"
+
+
+def print_tree(node: dict, out, indent: str = "  ") -> None:
+    """Print one node per line: kind, scalar, sizes, own and subtree cost."""
+    label = node["kind"] + (f"[{node['op']}]" if node.get("op") else "")
+    # "X" for dynamic sizes, as in MatrixXd
+    sizes = ""
+    if node["rows"] is not None:
+        sizes = "x".join(
+            "X" if size == "dynamic" else str(size) for size in (node["rows"], node["cols"])
+        )
+    description = " ".join(
+        part for part in (label, node["scalar"], sizes, node.get("storage")) if part
+    )
+    print(
+        f"{indent}{description}  "
+        f"flops {_cost(node['flops'])}/{_cost(node['total_flops'])}  "
+        f"bytes {_cost(node['bytes'])}/{_cost(node['total_bytes'])}",
+        file=out,
+    )
+    for operand in node["operands"]:
+        print_tree(operand, out, indent + "  ")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Dump Eigen expression types as trees with per-node cost"
+    )
+    parser.add_argument("source_file", help="C++ source file")
+    parser.add_argument(
+        "build_dir",
+        nargs="?",
+        default=".",
+        help="Directory with compile_commands.json (default: current directory)",
+    )
+    parser.add_argument(
+        "--expressions",
+        action="store_true",
+        help="Also dump every outermost Eigen-typed expression",
+    )
+    parser.add_argument(
+        "--dynamic-size",
+        type=int,
+        default=None,
+        help="Size assumed for dynamic dimensions in cost estimates",
+    )
+    parser.add_argument(
+        "--format", choices=("json", "text"), default="json", help="Output format"
+    )
+    parser.add_argument("--output", "-o", help="Write to this file instead of stdout")
+
+    # Everything after "--" is compiler flags, as for eigen_auto_check.py
+    argv = sys.argv[1:]
+    direct_flags = None
+    if "--" in argv:
+        split = argv.index("--")
+        argv, direct_flags = argv[:split], argv[split + 1 :]
+    args = parser.parse_args(argv)
+
+    filename = str(Path(args.source_file).resolve())
+    if direct_flags is not None:
+        compile_args = direct_flags
+    else:
+        compdb = checker.load_compilation_database(args.build_dir, only_file=filename)
+        compile_args = checker.get_compile_args(compdb, filename)
+
+    with open(filename, "r", encoding="utf-8") as f:
+        source_lines = f.readlines()
+    translation_unit = clang.cindex.Index.create().parse(filename, args=compile_args)
+    errors = [
+        d for d in translation_unit.diagnostics if d.severity >= clang.cindex.Diagnostic.Error
+    ]
+    if errors:
+        print(
+            f"Warning: {len(errors)} parse error(s), first: {errors[0].spelling}",
+            file=sys.stderr,
+        )
+
+    entries = collect_entries(translation_unit, filename, source_lines, args.expressions)
+    for entry in entries:
+        entry["tree"] = expression_tree(entry["type"], args.dynamic_size)
+
+    out = open(args.output, "w", encoding="utf-8") if args.output else sys.stdout
+    try:
+        if args.format == "json":
+            json.dump({"file": filename, "entries": entries}, out, indent=2)
+            out.write("\n")
+        else:
+            for entry in entries:
+                print(
+                    f"{filename}:{entry['line']}:{entry['column']}: "
+                    f"{entry['kind']} {entry['name']}: {entry['source']}",
+                    file=out,
+                )
+                print_tree(entry["tree"], out)
+    finally:
+        if args.output:
+            out.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,323 @@
+#!/usr/bin/env python3
+"""
+Standalone analysis of project headers through synthesized translation units.
+
+Checks only look at declarations of the main file, so inline helpers defined
+in headers are never analyzed when their includers are checked. Header mode
+checks each project header once instead:
+
+- the #include directives of every source file in the compilation database
+  are scanned (no parsing) to find the project headers, and each header
+  borrows the compile flags of the first source file that includes it;
+- includes that resolve outside the project (e.g. <Eigen/Dense>) form a
+  shared preamble per distinct flag set, which is precompiled once;
+- `#define` and `#undef` lines of the includer that precede its first
+  project include (e.g. `#define EIGEN_USE_THREADS`) are kept in the
+  preamble in their original order, so the header sees the same
+  configuration as in its includer;
+- each header is then parsed as a synthesized one-line translation unit
+  `#include "<header>"` on top of the precompiled preamble, so a header costs
+  little more than its own code instead of a full includer parse.
+
+Directives are scanned, not preprocessed: #if blocks are not evaluated, and
+macros defined after the first project include, or inside project headers
+for the headers they include, are not carried over. A header that relies on
+them fails to parse on its own; check_headers() reports such parse errors as
+header-mode failures.
+"""
+
+import hashlib
+import os
+import re
+from pathlib import Path
+
+import clang.cindex
+
+_INCLUDE_RE = re.compile(r'^\s*#\s*include\s*([<"])([^>"]+)[>"]')
+_MACRO_RE = re.compile(r"^\s*#\s*(?:define|undef)\b")
+
+# Flags whose value names an include search directory
+_QUOTE_DIR_FLAGS = ("-iquote",)
+_ANGLE_DIR_FLAGS = ("-I", "-isystem", "-idirafter")
+_SYSTEM_DIR_FLAGS = ("-isystem", "-idirafter")
+
+
+class HeaderUnit:
+    """A project header and the flags borrowed from one of its includers."""
+
+    __slots__ = ("header", "includer", "args", "preamble_key")
+
+    def __init__(self, header: str, includer: str, args: list, preamble_key: str):
+        self.header = header
+        self.includer = includer
+        self.args = args
+        self.preamble_key = preamble_key
+
+
+def scan_directives(path: str) -> list:
+    """
+    List the #include, #define and #undef directives of a file without
+    preprocessing it.
+
+    Returns:
+        List in file order of (name, quoted) tuples for includes and of the
+        directive's text (continuation lines joined) for macros
+    """
+    directives = []
+    try:
+        with open(path, "r", encoding="utf-8", errors="replace") as f:
+            lines = iter(f)
+            for line in lines:
+                match = _INCLUDE_RE.match(line)
+                if match:
+                    directives.append((match[2], match[1] == '"'))
+                elif _MACRO_RE.match(line):
+                    text = line.rstrip("\n")
+                    while text.endswith("\\"):
+                        text = text[:-1] + next(lines, "").rstrip("\n")
+                    directives.append(text.strip())
+    except OSError:
+        pass
+    return directives
+
+
+def scan_includes(path: str) -> list:
+    """
+    List the #include directives of a file without preprocessing it.
+
+    Returns:
+        List of (name, quoted) tuples in file order
+    """
+    return [
+        directive for directive in scan_directives(path) if isinstance(directive, tuple)
+    ]
+
+
+def search_paths(args: list) -> tuple:
+    """
+    Extract include search directories from compiler arguments.
+
+    Returns:
+        Tuple (quote directories, angle directories, system directories)
+    """
+    quote_dirs, angle_dirs, system_dirs = [], [], []
+    pending = None
+    for arg in args:
+        if pending is not None:
+            flag, pending = pending, None
+            value = arg
+        else:
+            for flag in _QUOTE_DIR_FLAGS + _ANGLE_DIR_FLAGS:
+                if arg == flag:
+                    pending = flag
+                    break
+                if arg.startswith(flag):
+                    value = arg[len(flag) :]
+                    break
+            else:
+                continue
+            if pending is not None:
+                continue
+        directory = os.path.normpath(os.path.abspath(value))
+        if flag in _QUOTE_DIR_FLAGS:
+            quote_dirs.append(directory)
+        else:
+            angle_dirs.append(directory)
+        if flag in _SYSTEM_DIR_FLAGS:
+            system_dirs.append(directory)
+    return quote_dirs, angle_dirs, system_dirs
+
+
+def resolve_include(
+    name: str, quoted: bool, current_dir: str, quote_dirs: list, angle_dirs: list
+):
+    """Resolve an include like the preprocessor would; None if not found."""
+    if os.path.isabs(name):
+        return os.path.normpath(name) if os.path.isfile(name) else None
+    candidates = ([current_dir] + quote_dirs if quoted else []) + angle_dirs
+    for directory in candidates:
+        path = os.path.join(directory, name)
+        if os.path.isfile(path):
+            return os.path.normpath(path)
+    return None
+
+
+def _is_filesystem_root(path: str) -> bool:
+    return os.path.dirname(path) == path
+
+
+def default_header_root(build_dir: str, files: list) -> str:
+    """
+    Guess the project root from the sources.
+
+    The deepest directory containing all sources is widened to include the
+    build directory when that is an in-tree build (the common parent is not
+    the filesystem root); an out-of-tree build directory is ignored.
+
+    Raises:
+        ValueError: If the sources themselves only share the filesystem root;
+            pass an explicit root then
+    """
+    if not files:
+        raise ValueError("no source files to derive the project root from")
+    root = os.path.commonpath([os.path.dirname(f) for f in files])
+    if _is_filesystem_root(root):
+        raise ValueError(
+            "the sources share no directory below the filesystem root; "
+            "pass --header-root"
+        )
+    with_build = os.path.commonpath([root, str(Path(build_dir).resolve())])
+    return root if _is_filesystem_root(with_build) else with_build
+
+
+def plan_headers(units: list, root: str) -> tuple:
+    """
+    Find the project headers reachable from the given source files.
+
+    A header belongs to the project if it lies under `root` and not in a
+    system include directory. Headers keep the flags of the first source file
+    (in the given order) that reaches them. Source files whose flags and
+    leading macros are identical share a preamble.
+
+    Args:
+        units: List of (source file, compiler arguments) tuples
+        root: Project root directory
+
+    Returns:
+        Tuple (list of HeaderUnit sorted by header, dict mapping preamble key
+        to (compiler arguments, list of external include and macro lines))
+    """
+    root = os.path.join(os.path.normpath(root), "")
+    headers = {}
+    preambles = {}
+
+    for filename, args in units:
+        args = [arg for arg in args if arg != filename]
+        quote_dirs, angle_dirs, system_dirs = search_paths(args)
+        system_prefixes = tuple(os.path.join(d, "") for d in system_dirs)
+
+        def project_path(name, quoted, current):
+            """Resolve an include; the path and whether it is a project header."""
+            path = resolve_include(
+                name, quoted, os.path.dirname(current), quote_dirs, angle_dirs
+            )
+            in_project = (
+                path is not None
+                and path.startswith(root)
+                and not path.startswith(system_prefixes)
+            )
+            return path, in_project
+
+        # The includer's macros up to its first project include
+        top_directives = scan_directives(filename)
+        macros = []
+        for directive in top_directives:
+            if isinstance(directive, str):
+                macros.append(directive)
+            elif project_path(*directive, filename)[1]:
+                break
+
+        key = hashlib.blake2b(
+            "\0".join(args + ["--"] + macros).encode(), digest_size=8
+        ).hexdigest()
+        _, preamble_lines = preambles.setdefault(key, (args, []))
+
+        visited = set()
+        pending = [filename]
+        while pending:
+            current = pending.pop()
+            if current == filename:
+                directives, in_prelude = top_directives, True
+            else:
+                directives, in_prelude = scan_includes(current), False
+            for directive in directives:
+                if isinstance(directive, str):
+                    if in_prelude and directive not in preamble_lines:
+                        preamble_lines.append(directive)
+                    continue
+                name, quoted = directive
+                path, in_project = project_path(name, quoted, current)
+                if not in_project:
+                    if not quoted:
+                        line = f"#include <{name}>"
+                    elif path is not None:
+                        line = f'#include "{path}"'
+                    else:
+                        # Would only break the preamble; the header reports it
+                        continue
+                    if line not in preamble_lines:
+                        preamble_lines.append(line)
+                    continue
+                in_prelude = False
+                if path in visited:
+                    continue
+                visited.add(path)
+                pending.append(path)
+                if path not in headers:
+                    headers[path] = HeaderUnit(path, filename, args, key)
+
+    return [headers[path] for path in sorted(headers)], preambles
+
+
+def build_preamble(
+    index: clang.cindex.Index, work_dir: str, key: str, args: list, lines: list
+):
+    """
+    Precompile a shared preamble of external includes.
+
+    Args:
+        index: Index to parse with
+        work_dir: Directory for the preamble source and PCH
+        key: Preamble key, used in the file names
+        args: Compiler arguments of the headers using this preamble
+        lines: #include lines of the preamble
+
+    Returns:
+        Path of the PCH, or None if it could not be built (headers are then
+        parsed without it)
+    """
+    source = os.path.join(work_dir, f"preamble_{key}.hpp")
+    pch = os.path.join(work_dir, f"preamble_{key}.pch")
+    with open(source, "w", encoding="utf-8") as f:
+        f.write("\n".join(lines) + "\n")
+    translation_unit = index.parse(source, args=args + ["-x", "c++-header"])
+    if any(
+        diag.severity >= clang.cindex.Diagnostic.Error
+        for diag in translation_unit.diagnostics
+    ):
+        return None
+    try:
+        translation_unit.save(pch)
+    except clang.cindex.TranslationUnitSaveError:
+        return None
+    return pch
+
+
+def parse_header(
+    index: clang.cindex.Index,
+    work_dir: str,
+    unit: HeaderUnit,
+    pch: str = None,
+    preamble_lines: list = (),
+):
+    """
+    Parse a header as the synthesized TU `#include "<header>"`.
+
+    Without a precompiled preamble, its lines are written into the
+    synthesized TU instead, so the header still sees the includer's external
+    includes and macros (at the cost of parsing them again).
+    """
+    digest = hashlib.blake2b(unit.header.encode(), digest_size=8).hexdigest()
+    synthesized = os.path.join(work_dir, f"header_{digest}.cpp")
+    args = list(unit.args)
+    lines = []
+    if pch is not None:
+        args += ["-include-pch", pch]
+    else:
+        lines += preamble_lines
+    lines.append(f'#include "{unit.header}"')
+    return index.parse(
+        synthesized,
+        args=args,
+        unsaved_files=[(synthesized, "\n".join(lines) + "\n")],
+    )
@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+"""
+Staged pipeline with bounded queues between stages.
+
+Each stage runs a number of worker threads that take items from the stage's
+input queue, transform them and put the result on the next stage's queue.
+Queues are bounded, so a slow stage applies back-pressure to the ones before
+it and the number of items in flight (and thus memory) stays bounded no
+matter how many items the source yields. I/O-bound stages overlap with the
+CPU-bound ones because they run on separate threads.
+
+Per stage the pipeline records items processed, busy time and input queue
+occupancy, so that the bottleneck of a run is visible. An exception raised by
+a stage function drops only the item it was processing; the pipeline records
+it in `errors` and keeps going, so one bad item does not cost the results of
+all the others.
+"""
+
+import threading
+import time
+from dataclasses import dataclass
+from queue import Queue
+
+# Marks the end of the stream on a queue
+_END = object()
+
+
+@dataclass
+class StageStats:
+    """Occupancy statistics of one pipeline stage."""
+
+    name: str
+    workers: int
+    items: int = 0
+    busy_s: float = 0.0
+    queue_samples: int = 0
+    queue_total: int = 0
+    queue_max: int = 0
+
+    @property
+    def queue_mean(self) -> float:
+        return self.queue_total / self.queue_samples if self.queue_samples else 0.0
+
+    def utilization(self, wall_s: float) -> float:
+        """Fraction of the stage's worker time spent busy."""
+        if wall_s <= 0:
+            return 0.0
+        return self.busy_s / (wall_s * self.workers)
+
+
+class _Stage:
+    def __init__(self, name, function, workers, passthrough, queue_size):
+        self.function = function
+        self.passthrough = passthrough
+        self.queue = Queue(maxsize=queue_size)
+        self.stats = StageStats(name, workers)
+        self.lock = threading.Lock()
+        self.running = workers
+
+
+class Pipeline:
+    """
+    A linear pipeline of thread-pool stages.
+
+    Usage:
+        pipeline = Pipeline(queue_size=16)
+        pipeline.add_stage("read", read_file, workers=2)
+        pipeline.add_stage("parse", parse, workers=8)
+        stats = pipeline.run(filenames)
+    """
+
+    def __init__(self, queue_size: int):
+        self.queue_size = queue_size
+        self.stages = []
+        self.wall_s = 0.0
+        # StageStats of the last run, the source first
+        self.stats = []
+        # (stage name, item, exception) for every item a stage raised on
+        self.errors = []
+
+    def add_stage(self, name: str, function, workers: int = 1, passthrough=None):
+        """
+        Append a stage.
+
+        Args:
+            name: Stage name for statistics
+            function: Called with each item; returns the item for the next
+                stage, or None to drop it
+            workers: Number of threads running this stage
+            passthrough: Optional predicate; matching items are forwarded to
+                the next stage without calling `function`
+        """
+        self.stages.append(
+            _Stage(name, function, max(workers, 1), passthrough, self.queue_size)
+        )
+
+    def _put(self, index: int, item) -> None:
+        if index < len(self.stages):
+            self.stages[index].queue.put(item)
+
+    def _worker(self, index: int) -> None:
+        stage = self.stages[index]
+        stats = stage.stats
+        while True:
+            depth = stage.queue.qsize()
+            item = stage.queue.get()
+            if item is _END:
+                break
+            with stage.lock:
+                stats.queue_samples += 1
+                stats.queue_total += depth
+                stats.queue_max = max(stats.queue_max, depth)
+
+            if stage.passthrough is not None and stage.passthrough(item):
+                self._put(index + 1, item)
+                continue
+
+            start = time.perf_counter()
+            try:
+                result = stage.function(item)
+            except Exception as e:  # keep draining so upstream never blocks
+                with stage.lock:
+                    self.errors.append((stats.name, item, e))
+                result = None
+            elapsed = time.perf_counter() - start
+            with stage.lock:
+                stats.items += 1
+                stats.busy_s += elapsed
+            if result is not None:
+                self._put(index + 1, result)
+
+        # The last worker of a stage to finish ends the next stage
+        with stage.lock:
+            stage.running -= 1
+            last = stage.running == 0
+        if last and index + 1 < len(self.stages):
+            for _ in range(self.stages[index + 1].stats.workers):
+                self._put(index + 1, _END)
+
+    def run(self, source, source_name: str = "enumerate") -> list:
+        """
+        Feed all items of `source` through the pipeline and wait for it.
+
+        Iterating `source` is accounted as the first stage. Items a stage
+        raised on are listed in `errors` afterwards.
+
+        Returns:
+            List of StageStats, the source first
+        """
+        start = time.perf_counter()
+        threads = []
+        for index, stage in enumerate(self.stages):
+            for _ in range(stage.stats.workers):
+                thread = threading.Thread(target=self._worker, args=(index,), daemon=True)
+                thread.start()
+                threads.append(thread)
+
+        source_stats = StageStats(source_name, 1)
+        iterator = iter(source)
+        while True:
+            item_start = time.perf_counter()
+            try:
+                item = next(iterator)
+            except StopIteration:
+                break
+            source_stats.busy_s += time.perf_counter() - item_start
+            source_stats.items += 1
+            self._put(0, item)
+        for _ in range(self.stages[0].stats.workers if self.stages else 0):
+            self._put(0, _END)
+
+        for thread in threads:
+            thread.join()
+        self.wall_s = time.perf_counter() - start
+
+        self.stats = [source_stats] + [stage.stats for stage in self.stages]
+        return self.stats
@@ -0,0 +1,283 @@
+#!/usr/bin/env python3
+"""
+Generate a synthetic C++/Eigen project for benchmarking the checker.
+
+Writes <output>/src/tu_NNNN.cpp translation units, <output>/include/ headers
+with inline helpers, a matching <output>/build/compile_commands.json (so the
+checker can be pointed at it without running CMake) and
+<output>/synthetic_project.json describing what was generated, including how
+many auto declarations the checker is expected to flag.
+
+Usage:
+    uv run synthetic_project.py /tmp/synth --tus 1000
+    uv run synthetic_project.py /tmp/synth --tus 200 --functions-per-tu 20 \\
+        --autos-per-function 8 --eigen-ratio 0.5 --header-fanout 4
+    uv run eigen_auto_check.py --all /tmp/synth/build
+"""
+
+import argparse
+import json
+import random
+import shlex
+from pathlib import Path
+
+# Eigen initializers: (expression, flagged by the checker)
+EIGEN_INITIALIZERS = [
+    ("A * B", True),
+    ("A + B", True),
+    ("A.transpose()", True),
+    ("A * B + A.transpose()", True),
+    ("(A * B).eval()", False),
+    ("A", False),
+]
+
+# Scalar initializers; never flagged
+SCALAR_INITIALIZERS = ["a * b", "a + b", "a"]
+
+
+def generate_header(header_index: int) -> str:
+    """Return the source of one project header with inline helpers."""
+    return f"""#pragma once
+#include <Eigen/Core>
+
+inline Eigen::MatrixXd header{header_index}_scale(const Eigen::MatrixXd& A, double s) {{
+    return A * s;
+}}
+
+inline double header{header_index}_trace(const Eigen::MatrixXd& A) {{
+    return A.trace();
+}}
+"""
+
+
+def generate_function(
+    rng: random.Random, name: str, autos: int, eigen_ratio: float
+) -> tuple:
+    """
+    Return the source of one function and the number of flagged declarations.
+
+    Args:
+        rng: Random source
+        name: Function name
+        autos: Number of auto declarations in the body
+        eigen_ratio: Fraction of declarations initialized from Eigen types
+    """
+    body = []
+    flagged = 0
+    for i in range(autos):
+        if rng.random() < eigen_ratio:
+            expression, is_flagged = rng.choice(EIGEN_INITIALIZERS)
+            flagged += is_flagged
+            body.append(f"    auto m{i} = {expression};")
+            body.append(f"    acc += m{i}(0, 0);")
+        else:
+            expression = rng.choice(SCALAR_INITIALIZERS)
+            body.append(f"    auto s{i} = {expression};")
+            body.append(f"    acc += s{i};")
+
+    source = (
+        f"double {name}(const Eigen::MatrixXd& A, const Eigen::MatrixXd& B, "
+        "double a, double b) {\n"
+        "    double acc = 0.0;\n" + "\n".join(body) + "\n    return acc;\n}\n"
+    )
+    return source, flagged
+
+
+def generate_tu(
+    rng: random.Random,
+    tu_index: int,
+    headers: list,
+    functions: int,
+    autos: int,
+    eigen_ratio: float,
+) -> tuple:
+    """
+    Return the source of one translation unit and its flagged count.
+
+    Args:
+        rng: Random source
+        tu_index: Index used to make function names unique
+        headers: Project header names to include
+        functions: Number of functions
+        autos: Auto declarations per function
+        eigen_ratio: Fraction of declarations initialized from Eigen types
+    """
+    parts = ["#include <Eigen/Core>"]
+    parts.extend(f'#include "{header}"' for header in headers)
+    parts.append("")
+
+    flagged = 0
+    for function_index in range(functions):
+        source, function_flagged = generate_function(
+            rng, f"tu{tu_index}_f{function_index}", autos, eigen_ratio
+        )
+        parts.append(source)
+        flagged += function_flagged
+
+    return "\n".join(parts), flagged
+
+
+def generate_project(
+    output: Path,
+    tus: int,
+    eigen_include: str,
+    extra_args: list,
+    functions: int = 3,
+    autos: int = 2,
+    eigen_ratio: float = 0.5,
+    header_count: int = 0,
+    header_fanout: int = 0,
+    seed: int = 0,
+) -> Path:
+    """
+    Write the synthetic project.
+
+    Args:
+        output: Directory to create the project in
+        tus: Number of translation units
+        eigen_include: Include directory containing Eigen/
+        extra_args: Additional compiler arguments for every TU
+        functions: Functions per translation unit
+        autos: Auto declarations per function
+        eigen_ratio: Fraction of auto declarations initialized from Eigen types
+        header_count: Size of the project header pool (default: header_fanout)
+        header_fanout: Project headers included by each translation unit
+        seed: Random seed; the same parameters always give the same project
+
+    Returns:
+        The build directory containing compile_commands.json
+    """
+    rng = random.Random(seed)
+    src_dir = output / "src"
+    include_dir = output / "include"
+    build_dir = output / "build"
+    for directory in (src_dir, include_dir, build_dir):
+        directory.mkdir(parents=True, exist_ok=True)
+
+    header_count = max(header_count, header_fanout)
+    header_names = [f"helpers_{i:03d}.h" for i in range(header_count)]
+    for header_index, header in enumerate(header_names):
+        (include_dir / header).write_text(
+            generate_header(header_index), encoding="utf-8"
+        )
+
+    commands = []
+    total_flagged = 0
+    for tu_index in range(tus):
+        source = src_dir / f"tu_{tu_index:04d}.cpp"
+        included = rng.sample(header_names, header_fanout)
+        text, flagged = generate_tu(
+            rng, tu_index, included, functions, autos, eigen_ratio
+        )
+        source.write_text(text, encoding="utf-8")
+        total_flagged += flagged
+        arguments = [
+            "c++",
+            "-std=c++20",
+            "-isystem",
+            eigen_include,
+            "-I",
+            str(include_dir.resolve()),
+            *extra_args,
+            "-o",
+            f"{source.stem}.o",
+            "-c",
+            str(source.resolve()),
+        ]
+        commands.append(
+            {
+                "directory": str(build_dir.resolve()),
+                "command": shlex.join(arguments),
+                "file": str(source.resolve()),
+            }
+        )
+
+    with open(build_dir / "compile_commands.json", "w", encoding="utf-8") as f:
+        json.dump(commands, f, indent=2)
+
+    manifest = {
+        "tus": tus,
+        "functions_per_tu": functions,
+        "autos_per_function": autos,
+        "eigen_ratio": eigen_ratio,
+        "header_count": header_count,
+        "header_fanout": header_fanout,
+        "seed": seed,
+        "declarations": tus * functions * autos,
+        "expected_findings": total_flagged,
+    }
+    with open(output / "synthetic_project.json", "w", encoding="utf-8") as f:
+        json.dump(manifest, f, indent=2)
+
+    return build_dir
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Generate a synthetic Eigen project for checker benchmarks"
+    )
+    parser.add_argument("output", help="Directory to write the project to")
+    parser.add_argument(
+        "--tus", type=int, default=100, help="Number of translation units"
+    )
+    parser.add_argument(
+        "--functions-per-tu", type=int, default=3, help="Functions per TU"
+    )
+    parser.add_argument(
+        "--autos-per-function",
+        type=int,
+        default=2,
+        help="auto declarations per function",
+    )
+    parser.add_argument(
+        "--eigen-ratio",
+        type=float,
+        default=0.5,
+        help="Fraction of auto declarations with Eigen types (default: 0.5)",
+    )
+    parser.add_argument(
+        "--headers",
+        type=int,
+        default=0,
+        help="Size of the project header pool (default: --header-fanout)",
+    )
+    parser.add_argument(
+        "--header-fanout",
+        type=int,
+        default=0,
+        help="Project headers included by each TU",
+    )
+    parser.add_argument("--seed", type=int, default=0, help="Random seed")
+    parser.add_argument(
+        "--eigen-include",
+        default="/usr/include/eigen3",
+        help="Eigen include directory (default: /usr/include/eigen3)",
+    )
+    parser.add_argument(
+        "--extra-arg",
+        action="append",
+        default=[],
+        help="Extra compiler argument for every TU (repeatable)",
+    )
+    args = parser.parse_args()
+
+    if not 0.0 <= args.eigen_ratio <= 1.0:
+        parser.error("--eigen-ratio must be between 0 and 1")
+
+    build_dir = generate_project(
+        Path(args.output),
+        args.tus,
+        args.eigen_include,
+        args.extra_arg,
+        functions=args.functions_per_tu,
+        autos=args.autos_per_function,
+        eigen_ratio=args.eigen_ratio,
+        header_count=args.headers,
+        header_fanout=args.header_fanout,
+        seed=args.seed,
+    )
+    print(f"Wrote {args.tus} translation unit(s); compile_commands.json in {build_dir}")
+
+
+if __name__ == "__main__":
+    main()